@@ -0,0 +1,723 @@
+/**
+ *          Bulk Input
+ * --------------------------------------------------
+ * 1_1_input_output.cpp reads one integer at a time with std::cin >> number
+ *      and recovers from bad input with cin.clear()/cin.ignore().
+ * That is fine for a prompt but way too slow for files with millions of numbers
+ *      (locale lookups, sentry objects, virtual streambuf calls per value)
+ *
+ * Batch mode:
+ *      read stdin in big blocks (fread), split into lines,
+ *      parse each line with from_chars (no locale, no allocation)
+ *
+ * Same rule as the cin loop:
+ *      leading blanks are skipped, empty lines are skipped
+ *      "42abc" -> 42 (rest of the line is ignored, like cin.ignore())
+ *      "abc", "-", "99999999999" -> bad line, reported and skipped
+ *
+ * File mode (POSIX):
+ *      regular files are mmap'd and parsed straight from the mapped pages,
+ *      no copy into a string or a stream buffer. madvise(MADV_SEQUENTIAL) lets the
+ *      kernel read ahead aggressively and drop pages behind us.
+ *      pipes, fifos, ttys (and anything mmap refuses) fall back to buffered reads
+ *
+ * SIMD kernel:
+ *      Classify32 turns 32 bytes into digit/sign/space/garbage bit masks (AVX2, or 2 x SSE2),
+ *      so finding the number inside a line is a couple of ctz's instead of a char loop.
+ *      Digits16 converts up to 16 digits with shuffle + multiply-add lanes (SSSE3),
+ *      Digits8 is the SWAR fallback. Overflow is checked against numeric_limits<int>.
+ *      build with -march=native (or -mavx2 / -mssse3) to get the vector paths
+ *
+ * Parallel mode:
+ *      the mapped file is cut into N ranges, every cut moved to the next newline,
+ *      each range parsed on its own thread and the results merged back in file order
+ *      (values, bad line numbers and line counts identical to the single thread run)
+ *
+ * Modern C++:
+ *  C++11~ -> thread was added, no more platform thread APIs for simple fork/join
+ *  C++17~ -> from_chars was added for locale independent, non-throwing conversion
+ *
+ * Usage:
+ *      1_1_2_bulkInput < numbers.txt            // batch mode
+ *      1_1_2_bulkInput numbers.txt              // file mode (mmap)
+ *      1_1_2_bulkInput --threads N numbers.txt  // file mode, N threads
+ *      1_1_2_bulkInput --cin < numbers.txt      // the old cin loop, for comparison
+ *      1_1_2_bulkInput --bench [N ...]          // cin vs batch, default 1M 10M 100M
+ *      1_1_2_bulkInput --bench-simd [N ...]     // scalar vs SIMD kernel in GB/s
+ *      1_1_2_bulkInput --bench-threads [N [T]]  // 1, 2, 4 .. T threads over N values
+ *      1_1_2_bulkInput --check [N]              // SIMD kernel vs scalar on edge cases + N random lines
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace BulkInput {
+    // what we got out of the input
+    struct Result {
+        std::vector<int> values;
+        std::vector<long long> badLines;    // 1-based line numbers
+        long long lineCount = 0;
+    };
+
+    // one line without the '\n'. true if it starts with a valid int
+    inline bool ParseLine(const char* first, const char* last, int& value) {
+        while (first != last && (*first == ' ' || *first == '\t' || *first == '\r')) {
+            ++first;
+        }
+        if (first != last && *first == '+') {  // cin accepts '+', from_chars doesn't
+            ++first;
+            if (first == last || *first == '-') {
+                return false;
+            }
+        }
+        std::from_chars_result r = std::from_chars(first, last, value);
+        return r.ec == std::errc();         // invalid_argument or result_out_of_range
+    }
+
+    inline bool IsBlankLine(const char* first, const char* last) {
+        for (; first != last; ++first) {
+            if (*first != ' ' && *first != '\t' && *first != '\r') {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*      SIMD kernel     */
+    // Byte classes of a 32 byte window, one bit per byte (bit i == p[i])
+    struct ByteClass {
+        uint32_t digit;     // '0'~'9'
+        uint32_t sign;      // '+' '-'
+        uint32_t space;     // ' ' '\t' '\r' '\n'
+        uint32_t other;     // garbage
+    };
+
+#if defined(__SSE2__)
+    inline void Classify16(__m128i v, uint32_t& digit, uint32_t& sign, uint32_t& space) {
+        // only signed compares in SSE2, but '0'~'9' are positive so bytes >= 0x80 fail anyway
+        __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                        _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+        __m128i isSign = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('+')),
+                                      _mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+        __m128i isSpace = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                                    _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                                       _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+                                                    _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+        digit = static_cast<uint32_t>(_mm_movemask_epi8(isDigit));
+        sign = static_cast<uint32_t>(_mm_movemask_epi8(isSign));
+        space = static_cast<uint32_t>(_mm_movemask_epi8(isSpace));
+    }
+#endif
+
+    // p[0] ~ p[31] must be readable
+    inline ByteClass Classify32(const char* p) {
+        ByteClass c;
+#if defined(__AVX2__)
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i isDigit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)),
+                                           _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+        __m256i isSign = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('+')),
+                                         _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')));
+        __m256i isSpace = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                                          _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                                          _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')),
+                                                          _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+        c.digit = static_cast<uint32_t>(_mm256_movemask_epi8(isDigit));
+        c.sign = static_cast<uint32_t>(_mm256_movemask_epi8(isSign));
+        c.space = static_cast<uint32_t>(_mm256_movemask_epi8(isSpace));
+#elif defined(__SSE2__)
+        uint32_t d0, s0, w0, d1, s1, w1;
+        Classify16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), d0, s0, w0);
+        Classify16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)), d1, s1, w1);
+        c.digit = d0 | (d1 << 16);
+        c.sign = s0 | (s1 << 16);
+        c.space = w0 | (w1 << 16);
+#else
+        c.digit = c.sign = c.space = 0;
+        for (int i = 0; i < 32; ++i) {
+            unsigned char ch = static_cast<unsigned char>(p[i]);
+            uint32_t bit = 1u << i;
+            if (ch >= '0' && ch <= '9') c.digit |= bit;
+            else if (ch == '+' || ch == '-') c.sign |= bit;
+            else if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') c.space |= bit;
+        }
+#endif
+        c.other = ~(c.digit | c.sign | c.space);
+        return c;
+    }
+
+    // p[0] ~ p[31] must be readable
+    inline uint32_t NewlineMask32(const char* p) {
+#if defined(__AVX2__)
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+#elif defined(__SSE2__)
+        __m128i nl = _mm_set1_epi8('\n');
+        uint32_t lo = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), nl)));
+        uint32_t hi = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)), nl)));
+        return lo | (hi << 16);
+#else
+        uint32_t mask = 0;
+        for (int i = 0; i < 32; ++i) {
+            mask |= static_cast<uint32_t>(p[i] == '\n') << i;
+        }
+        return mask;
+#endif
+    }
+
+    inline int CountTrailingZeros(uint64_t x) {  // x != 0
+#if defined(_MSC_VER)
+        unsigned long i;
+        _BitScanForward64(&i, x);
+        return static_cast<int>(i);
+#else
+        return __builtin_ctzll(x);
+#endif
+    }
+
+    // n (1~8) ascii digits at p -> number. p[0] ~ p[7] must be readable
+    //      SWAR: 8 digits in one 64 bit register, 3 multiply-adds instead of 8
+    inline uint32_t Digits8(const char* p, int n) {
+        uint64_t chunk;
+        std::memcpy(&chunk, p, 8);                  // p[0] lands in the low byte
+        chunk -= 0x3030303030303030ull;
+        chunk <<= 8 * (8 - n);                      // right align, zeros on the left
+        chunk = (chunk * 10) + (chunk >> 8);        // 2 digits per 16 bits
+        chunk = (((chunk & 0x000000FF000000FFull) * 0x000F424000000064ull) +
+                 (((chunk >> 16) & 0x000000FF000000FFull) * 0x0000271000000001ull)) >> 32;
+        return static_cast<uint32_t>(chunk);
+    }
+
+#if defined(__SSSE3__)
+    // shuffle masks that right-align n digits in a 16 byte lane (0x80 -> zero)
+    struct AlignTable {
+        alignas(16) int8_t mask[17][16];
+        AlignTable() {
+            for (int n = 0; n <= 16; ++n) {
+                for (int i = 0; i < 16; ++i) {
+                    mask[n][i] = static_cast<int8_t>(i >= 16 - n ? i - (16 - n) : 0x80);
+                }
+            }
+        }
+    };
+#endif
+
+    // n (1~16) ascii digits at p -> number. p[0] ~ p[15] must be readable
+    inline uint64_t Digits16(const char* p, int n) {
+#if defined(__SSSE3__)
+        static const AlignTable table;
+        __m128i v = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), _mm_set1_epi8('0'));
+        v = _mm_shuffle_epi8(v, _mm_load_si128(reinterpret_cast<const __m128i*>(table.mask[n])));
+        v = _mm_maddubs_epi16(v, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1)); // 8 x 2 digits
+        v = _mm_madd_epi16(v, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));   // 4 x 4 digits
+        v = _mm_packs_epi32(v, v);                                               // (<= 9999, no saturation)
+        v = _mm_madd_epi16(v, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1)); // 2 x 8 digits
+        uint64_t hi = static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+        uint64_t lo = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(v, 4)));
+        return hi * 100000000ull + lo;
+#else
+        if (n <= 8) {
+            return Digits8(p, n);
+        }
+        return Digits8(p, n - 8) * 100000000ull + Digits8(p + n - 8, 8);
+#endif
+    }
+
+    // Same rule as ParseLine, but classifies the line 32 bytes at a time and converts the
+    //      digit run with Digits16. [first, limit) has to be readable (limit is the end of the
+    //      buffer, not of the line) so we never load past a mapping.
+    //      Anything unusual (short buffer, > 16 digits, long blank prefix) goes to ParseLine
+    inline bool ParseLineSimd(const char* first, const char* last, const char* limit, int& value) {
+        if (limit - first < 32) {
+            return ParseLine(first, last, value);
+        }
+        ptrdiff_t length = last - first;
+        uint32_t inLine = length >= 32 ? ~0u : ((1u << length) - 1);
+        ByteClass c = Classify32(first);
+
+        uint32_t notBlank = ~c.space & inLine;
+        if (notBlank == 0) {
+            return length >= 32 ? ParseLine(first, last, value) : false;   // blank line
+        }
+        int pos = CountTrailingZeros(notBlank);
+        int hasSign = static_cast<int>((c.sign >> pos) & 1);   // no branch, signs are random in real data
+        bool negative = hasSign & (first[pos] == '-');
+        pos += hasSign;
+        if (pos >= 16) {
+            return ParseLine(first, last, value);
+        }
+        uint64_t notDigit = ~(static_cast<uint64_t>(c.digit & inLine) >> pos);
+        int digits = CountTrailingZeros(notDigit);  // never 0 input, bits above 32 - pos are set
+        if (digits == 0) {
+            return false;           // "abc", "-", "+-1"
+        }
+        if (digits > 16) {
+            return ParseLine(first, last, value);   // lots of leading zeros
+        }
+        uint64_t magnitude = Digits16(first + pos, digits);
+        uint64_t max = static_cast<uint64_t>(std::numeric_limits<int>::max()) + (negative ? 1 : 0);
+        if (magnitude > max) {
+            return false;           // like cin, out of range is a bad line
+        }
+        value = static_cast<int>(negative ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude));
+        return true;
+    }
+
+    // Takes the input block by block. A line cut by the block boundary is kept in m_Tail
+    //      so only that one line is ever copied
+    class Reader {
+        Result& m_Result;
+        std::string m_Tail;
+        bool m_Simd;
+    public:
+        explicit Reader(Result& result, bool simd = true) : m_Result(result), m_Simd(simd) {}
+
+        void Feed(const char* data, size_t size) {
+            const char* last = data + size;
+            const char* line = data;
+            if (!m_Tail.empty()) {
+                const char* nl = static_cast<const char*>(std::memchr(data, '\n', size));
+                if (nl == nullptr) {
+                    m_Tail.append(data, size);
+                    return;
+                }
+                m_Tail.append(data, nl);
+                Line(m_Tail.data(), m_Tail.data() + m_Tail.size(), m_Tail.data() + m_Tail.size());
+                m_Tail.clear();
+                line = nl + 1;
+            }
+            if (m_Simd) {
+                // newline bits of 32 byte windows instead of one memchr call per short line
+                for (const char* window = line; last - window >= 32; window += 32) {
+                    for (uint32_t mask = NewlineMask32(window); mask != 0; mask &= mask - 1) {
+                        const char* nl = window + CountTrailingZeros(mask);
+                        Line(line, nl, last);
+                        line = nl + 1;
+                    }
+                }
+            }
+            while (line != last) {
+                const char* nl = static_cast<const char*>(std::memchr(line, '\n', last - line));
+                if (nl == nullptr) {
+                    m_Tail.assign(line, last);
+                    return;
+                }
+                Line(line, nl, last);
+                line = nl + 1;
+            }
+        }
+
+        void Finish() {
+            if (!m_Tail.empty()) {
+                Line(m_Tail.data(), m_Tail.data() + m_Tail.size(), m_Tail.data() + m_Tail.size());
+                m_Tail.clear();
+            }
+        }
+
+    private:
+        // limit: end of the readable buffer the line lives in
+        void Line(const char* first, const char* last, const char* limit) {
+            ++m_Result.lineCount;
+            int value;
+            bool ok = m_Simd ? ParseLineSimd(first, last, limit, value) : ParseLine(first, last, value);
+            if (ok) {
+                m_Result.values.push_back(value);
+            } else if (!IsBlankLine(first, last)) {
+                m_Result.badLines.push_back(m_Result.lineCount);
+            }
+        }
+    };
+
+    // batch mode over a FILE*
+    inline Result ReadStream(std::FILE* file) {
+        const size_t blockSize = 1 << 20;   // 1MB
+        std::vector<char> block(blockSize);
+        Result result;
+        Reader reader(result);
+        size_t n;
+        while ((n = std::fread(block.data(), 1, blockSize, file)) > 0) {
+            reader.Feed(block.data(), n);
+        }
+        reader.Finish();
+        return result;
+    }
+
+    // Parallel mode: split [data, data + size) into ranges, move every cut to just after the
+    //      next '\n' so no line is split, parse each range on its own thread, then stitch the
+    //      results together in file order (line numbers shifted by the lines of earlier ranges).
+    //      The output is exactly what one Reader over the whole range gives.
+    inline Result ReadParallel(const char* data, size_t size, unsigned threadCount) {
+        const size_t minChunk = 1 << 20;    // not worth a thread below 1MB
+        threadCount = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threadCount, size / minChunk)));
+
+        std::vector<const char*> cuts(threadCount + 1);
+        cuts[0] = data;
+        cuts[threadCount] = data + size;
+        for (unsigned i = 1; i < threadCount; ++i) {
+            const char* cut = std::max(data + size / threadCount * i, cuts[i - 1]);
+            const char* nl = static_cast<const char*>(std::memchr(cut, '\n', data + size - cut));
+            cuts[i] = nl != nullptr ? nl + 1 : data + size;
+        }
+
+        std::vector<Result> parts(threadCount);
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < threadCount; ++i) {
+            threads.emplace_back([&, i]() {
+                Reader reader(parts[i]);
+                reader.Feed(cuts[i], cuts[i + 1] - cuts[i]);
+                reader.Finish();    // only the last range can end without '\n'
+            });
+        }
+        for (std::thread& t : threads) {
+            t.join();
+        }
+        threads.clear();
+
+        // where every part goes in the merged result
+        std::vector<size_t> valueOffset(threadCount + 1, 0);
+        std::vector<size_t> badOffset(threadCount + 1, 0);
+        std::vector<long long> lineOffset(threadCount + 1, 0);
+        for (unsigned i = 0; i < threadCount; ++i) {
+            valueOffset[i + 1] = valueOffset[i] + parts[i].values.size();
+            badOffset[i + 1] = badOffset[i] + parts[i].badLines.size();
+            lineOffset[i + 1] = lineOffset[i] + parts[i].lineCount;
+        }
+
+        Result result;
+        result.values.resize(valueOffset[threadCount]);
+        result.badLines.resize(badOffset[threadCount]);
+        result.lineCount = lineOffset[threadCount];
+        for (unsigned i = 0; i < threadCount; ++i) {  // the copy is as big as the parse output, do it in parallel too
+            threads.emplace_back([&, i]() {
+                std::copy(parts[i].values.begin(), parts[i].values.end(), result.values.begin() + valueOffset[i]);
+                for (size_t j = 0; j < parts[i].badLines.size(); ++j) {
+                    result.badLines[badOffset[i] + j] = parts[i].badLines[j] + lineOffset[i];
+                }
+                std::vector<int>().swap(parts[i].values);
+            });
+        }
+        for (std::thread& t : threads) {
+            t.join();
+        }
+        return result;
+    }
+
+    // file mode. returns false if the file can't be opened
+    //      threadCount > 1 parses the mapping with ReadParallel (not for pipes, they can't be split)
+    inline bool ReadFile(const char* path, Result& result, unsigned threadCount = 1) {
+#if defined(_WIN32)
+        std::FILE* file = std::fopen(path, "rb");
+        if (file == nullptr) {
+            return false;
+        }
+        result = ReadStream(file);
+        std::fclose(file);
+        (void)threadCount;
+        return true;
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            size_t size = static_cast<size_t>(st.st_size);
+            void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+                ::madvise(map, size, MADV_SEQUENTIAL);
+                if (threadCount > 1) {
+                    result = ReadParallel(static_cast<const char*>(map), size, threadCount);
+                } else {
+                    result = Result();
+                    Reader reader(result);
+                    reader.Feed(static_cast<const char*>(map), size);  // the whole file is one block
+                    reader.Finish();
+                }
+                ::munmap(map, size);
+                ::close(fd);
+                return true;
+            }
+        }
+
+        // pipe, fifo, empty or unmappable file -> plain buffered read()
+        const size_t blockSize = 1 << 20;
+        std::vector<char> block(blockSize);
+        result = Result();
+        Reader reader(result);
+        ssize_t n;
+        while ((n = ::read(fd, block.data(), blockSize)) != 0) {
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            reader.Feed(block.data(), static_cast<size_t>(n));
+        }
+        reader.Finish();
+        ::close(fd);
+        return true;
+#endif
+    }
+
+    // the 1_1_input_output.cpp loop, made to run until end of input
+    inline Result ReadCin(std::istream& in) {
+        Result result;
+        int number;
+        while (true) {
+            // >> would eat blank lines silently, so skip them here to keep line numbers right
+            int c;
+            while ((c = in.peek()) == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                if (in.get() == '\n') {
+                    ++result.lineCount;
+                }
+            }
+            in >> number;
+            if (in.eof() && in.fail()) {
+                break;
+            }
+            ++result.lineCount;
+            if (in.fail()) {
+                in.clear();
+                in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                result.badLines.push_back(result.lineCount);
+            } else {
+                result.values.push_back(number);
+                in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            }
+        }
+        return result;
+    }
+
+    inline void Report(const Result& result, std::ostream& out, std::ostream& err) {
+        for (long long line : result.badLines) {
+            err << "line " << line << ": That's not a valid number." << "\n";
+        }
+        long long sum = 0;
+        for (int v : result.values) {
+            sum += v;
+        }
+        out << "read " << result.values.size() << " numbers, "
+            << result.badLines.size() << " bad lines, sum " << sum << std::endl;
+    }
+
+    // every 1000th line is garbage so the error path is measured too
+    inline std::string MakeInput(long long count) {
+        std::string text;
+        text.reserve(static_cast<size_t>(count) * 8);
+        unsigned int seed = 12345;
+        char buf[16];
+        for (long long i = 0; i < count; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            if (i % 1000 == 999) {
+                text += "oops\n";
+                continue;
+            }
+            int v = static_cast<int>(seed >> 8) - (1 << 23);
+            std::to_chars_result r = std::to_chars(buf, buf + sizeof(buf), v);
+            text.append(buf, r.ptr);
+            text += '\n';
+        }
+        return text;
+    }
+
+    inline void Bench(long long count) {
+        typedef std::chrono::steady_clock Clock;
+        std::string text = MakeInput(count);
+        double mb = text.size() / (1024.0 * 1024.0);
+
+        Clock::time_point t0 = Clock::now();
+        std::istringstream in(text);
+        Result slow = ReadCin(in);
+        Clock::time_point t1 = Clock::now();
+
+        Result fast;
+        {
+            Reader reader(fast);
+            const size_t blockSize = 1 << 20;
+            for (size_t pos = 0; pos < text.size(); pos += blockSize) {   // same block size as stdin
+                reader.Feed(text.data() + pos, std::min(blockSize, text.size() - pos));
+            }
+            reader.Finish();
+        }
+        Clock::time_point t2 = Clock::now();
+
+        double cinSec = std::chrono::duration<double>(t1 - t0).count();
+        double bulkSec = std::chrono::duration<double>(t2 - t1).count();
+        bool same = slow.values == fast.values && slow.badLines == fast.badLines;
+        std::printf("%11lld values %8.1f MB | cin %8.3f s %8.1f MB/s | bulk %8.3f s %8.1f MB/s | x%.1f %s\n",
+                    count, mb, cinSec, mb / cinSec, bulkSec, mb / bulkSec, cinSec / bulkSec,
+                    same ? "" : "MISMATCH");
+    }
+
+    // ParseLineSimd vs ParseLine over edge cases and random lines. returns mismatch count
+    inline long long CheckSimd(long long randomCases) {
+        std::vector<std::string> lines = {
+            "", " ", "\t\r", "0", "-0", "+0", "7", "-7", "+7", "42abc", "abc", "-", "+", "+-1", "-+1",
+            "- 1", "2147483647", "2147483648", "-2147483648", "-2147483649", "4294967296",
+            "9999999999999999", "99999999999999999", "0000000000000042", "00000000000000000000042",
+            "1234567890123456", "   \t  -123   ", std::string(40, ' ') + "5", std::string(20, ' ') + "-9x",
+            "\xff\x80" "12", "12\xff", "1 2", "0x10"
+        };
+        unsigned int seed = 777;
+        const char alphabet[] = "0123456789000000+- \t\rx\x80";
+        for (long long i = 0; i < randomCases; ++i) {
+            std::string line;
+            int length = static_cast<int>((seed = seed * 1103515245u + 12345u) >> 16) % 24;
+            for (int j = 0; j < length; ++j) {
+                seed = seed * 1103515245u + 12345u;
+                line += alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+            }
+            lines.push_back(line);
+        }
+
+        long long mismatches = 0;
+        std::vector<char> buffer;
+        for (const std::string& line : lines) {
+            // once with room behind the line (SIMD path), once flush with the end (scalar path)
+            for (size_t padding : {static_cast<size_t>(64), static_cast<size_t>(0)}) {
+                buffer.assign(line.begin(), line.end());
+                buffer.push_back('\n');
+                buffer.resize(buffer.size() + padding, '9');
+                const char* first = buffer.data();
+                const char* last = first + line.size();
+                int expected = 0, actual = 0;
+                bool ok1 = ParseLine(first, last, expected);
+                bool ok2 = ParseLineSimd(first, last, first + buffer.size(), actual);
+                if (ok1 != ok2 || (ok1 && expected != actual)) {
+                    if (++mismatches <= 10) {
+                        std::cerr << "mismatch \"" << line << "\": scalar " << ok1 << "/" << expected
+                                  << " simd " << ok2 << "/" << actual << "\n";
+                    }
+                }
+            }
+        }
+        std::cout << lines.size() << " lines checked, " << mismatches << " mismatches" << std::endl;
+        return mismatches;
+    }
+
+    // parse throughput of the whole in-memory text (like file mode), scalar vs SIMD kernel
+    inline void BenchSimd(long long count) {
+        typedef std::chrono::steady_clock Clock;
+        std::string text = MakeInput(count);
+        double gb = text.size() / (1024.0 * 1024.0 * 1024.0);
+        double sec[2];
+        Result results[2];
+        for (int simd = 0; simd < 2; ++simd) {
+            Clock::time_point t0 = Clock::now();
+            Reader reader(results[simd], simd == 1);
+            reader.Feed(text.data(), text.size());
+            reader.Finish();
+            sec[simd] = std::chrono::duration<double>(Clock::now() - t0).count();
+        }
+        bool same = results[0].values == results[1].values && results[0].badLines == results[1].badLines;
+        std::printf("%11lld values %8.3f GB | scalar %6.2f GB/s | simd %6.2f GB/s | x%.2f %s\n",
+                    count, gb, gb / sec[0], gb / sec[1], sec[0] / sec[1], same ? "" : "MISMATCH");
+    }
+
+    // 1, 2, 4, ... threads over the same in-memory text, checked against the single thread result
+    inline void BenchThreads(long long count, unsigned maxThreads) {
+        typedef std::chrono::steady_clock Clock;
+        std::string text = MakeInput(count);
+        double gb = text.size() / (1024.0 * 1024.0 * 1024.0);
+        Result single;
+        double singleSec = 0;
+        for (unsigned threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+            Clock::time_point t0 = Clock::now();
+            Result result = ReadParallel(text.data(), text.size(), threadCount);
+            double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+            if (threadCount == 1) {
+                single = result;
+                singleSec = sec;
+            }
+            bool same = result.values == single.values && result.badLines == single.badLines &&
+                        result.lineCount == single.lineCount;
+            std::printf("%3u threads %8.3f GB | %8.3f s %6.2f GB/s | x%.2f %s\n",
+                        threadCount, gb, sec, gb / sec, singleSec / sec, same ? "" : "MISMATCH");
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        std::vector<long long> counts;
+        for (int i = 2; i < argc; ++i) {
+            counts.push_back(std::atoll(argv[i]));
+        }
+        if (counts.empty()) {
+            counts = {1000000, 10000000, 100000000};
+        }
+        for (long long count : counts) {
+            BulkInput::Bench(count);
+        }
+        return 0;
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "--bench-simd") == 0) {
+        for (int i = 2; i < argc; ++i) {
+            BulkInput::BenchSimd(std::atoll(argv[i]));
+        }
+        if (argc == 2) {
+            BulkInput::BenchSimd(10000000);
+        }
+        return 0;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+        return BulkInput::CheckSimd(argc > 2 ? std::atoll(argv[2]) : 1000000) == 0 ? 0 : 1;
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "--bench-threads") == 0) {
+        unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+        BulkInput::BenchThreads(argc > 2 ? std::atoll(argv[2]) : 100000000,
+                                argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : hardware);
+        return 0;
+    }
+
+    BulkInput::Result result;
+    if (argc > 3 && std::strcmp(argv[1], "--threads") == 0) {
+        if (!BulkInput::ReadFile(argv[3], result, static_cast<unsigned>(std::atoi(argv[2])))) {
+            std::cerr << "can't open " << argv[3] << std::endl;
+            return 1;
+        }
+    } else if (argc > 1 && std::strcmp(argv[1], "--cin") == 0) {
+        std::ios::sync_with_stdio(false);
+        result = BulkInput::ReadCin(std::cin);
+    } else if (argc > 1) {
+        if (!BulkInput::ReadFile(argv[1], result)) {
+            std::cerr << "can't open " << argv[1] << std::endl;
+            return 1;
+        }
+    } else {
+        result = BulkInput::ReadStream(stdin);
+    }
+    BulkInput::Report(result, std::cout, std::cerr);
+    return 0;
+}
@@ -0,0 +1,741 @@
+/**
+ *          TextEditor
+ * --------------------------------------------------
+ * 1_2_naming.cpp only names the API:
+ *      TextEditor textEditor;
+ *      textEditor.Select(0, 3);
+ *      textEditor.Remove();
+ * This is a real one for documents of hundreds of MB
+ *
+ * std::string as the document:
+ *      every insert/erase in the middle moves everything behind it (memmove of ~n/2 bytes)
+ *
+ * Piece table:
+ *      the text is never moved. The original file stays in buffer 0 and everything typed
+ *      is appended to add buffers (fixed capacity, so they never reallocate either).
+ *      The document is a sequence of pieces {buffer, start, length}.
+ *      The pieces live in a treap keyed by position (each node knows the length of its subtree),
+ *      so finding, splitting and joining at a position is O(log n) in the number of pieces.
+ *
+ * Find/FindAll:
+ *      search each piece in place (TextSearch below), plus a small seam buffer per piece
+ *      boundary for matches that cross it. The document is never joined into one string.
+ *
+ * Usage:
+ *      1_2_2_textEditor                        // the 1_2_naming.cpp example
+ *      1_2_2_textEditor --check [N]            // N random edits against std::string
+ *      1_2_2_textEditor --bench [MB [EDITS]]   // random edits, piece table vs std::string
+ *      1_2_2_textEditor --bench-find [MB]      // FindAll vs std::string::find
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+// Substring search over one contiguous buffer.
+//      short patterns: SIMD filter on the first and last byte of the pattern (16/32 positions
+//      per compare), then memcmp only on candidates
+//      long patterns: Two-Way (Crochemore-Perrin), linear time and O(1) memory, no bad cases
+namespace TextSearch {
+    const size_t s_TwoWayThreshold = 64;
+
+    class Pattern {
+        std::string m_Text;
+        size_t m_Critical = 0;      // Two-Way critical factorization: x[0..ell] | x[ell+1..]
+        size_t m_Period = 1;
+        bool m_Periodic = false;
+        size_t m_Shift[256];        // distance from the last occurrence of a byte to the end
+    public:
+        explicit Pattern(std::string text) : m_Text(std::move(text)) {
+            if (m_Text.size() > s_TwoWayThreshold) {
+                size_t p, q;
+                ptrdiff_t i = MaxSuffix(false, p);
+                ptrdiff_t j = MaxSuffix(true, q);
+                ptrdiff_t ell = std::max(i, j);
+                m_Critical = static_cast<size_t>(ell);
+                m_Period = i > j ? p : q;
+                m_Periodic = m_Period + ell + 1 <= m_Text.size() &&
+                             std::memcmp(m_Text.data(), m_Text.data() + m_Period, ell + 1) == 0;
+                if (!m_Periodic) {
+                    m_Period = std::max<size_t>(ell + 1, m_Text.size() - ell - 1) + 1;
+                }
+                for (size_t& shift : m_Shift) {
+                    shift = m_Text.size();
+                }
+                for (size_t k = 0; k < m_Text.size(); ++k) {
+                    m_Shift[static_cast<unsigned char>(m_Text[k])] = m_Text.size() - 1 - k;
+                }
+            }
+        }
+        const char* Data() const { return m_Text.data(); }
+        size_t Size() const { return m_Text.size(); }
+        size_t Critical() const { return m_Critical; }
+        size_t Period() const { return m_Period; }
+        bool Periodic() const { return m_Periodic; }
+        size_t Shift(unsigned char c) const { return m_Shift[c]; }
+
+    private:
+        // start of the maximal suffix (-1 based like the paper) and its period
+        ptrdiff_t MaxSuffix(bool reverse, size_t& period) const {
+            const unsigned char* x = reinterpret_cast<const unsigned char*>(m_Text.data());
+            ptrdiff_t m = static_cast<ptrdiff_t>(m_Text.size());
+            ptrdiff_t ms = -1, j = 0, k = 1, p = 1;
+            while (j + k < m) {
+                unsigned char a = x[j + k];
+                unsigned char b = x[ms + k];
+                if (reverse ? a > b : a < b) {
+                    j += k;
+                    k = 1;
+                    p = j - ms;
+                } else if (a == b) {
+                    if (k != p) {
+                        ++k;
+                    } else {
+                        j += p;
+                        k = 1;
+                    }
+                } else {
+                    ms = j;
+                    j = ms + 1;
+                    k = p = 1;
+                }
+            }
+            period = static_cast<size_t>(p);
+            return ms;
+        }
+    };
+
+    // onMatch(size_t pos) -> false to stop. returns false if stopped
+    //      (the glibc flavour: a bad character shift on the last byte skips most windows
+    //      before the critical factorization is even looked at)
+    template <typename F>
+    bool TwoWay(const char* text, size_t n, const Pattern& pattern, F onMatch) {
+        const unsigned char* x = reinterpret_cast<const unsigned char*>(pattern.Data());
+        const unsigned char* y = reinterpret_cast<const unsigned char*>(text);
+        size_t m = pattern.Size();
+        size_t suffix = pattern.Critical() + 1;
+        size_t period = pattern.Period();
+        size_t j = 0;
+        if (pattern.Periodic()) {
+            size_t memory = 0;          // prefix already known to match after a period shift
+            while (j + m <= n) {
+                size_t shift = pattern.Shift(y[j + m - 1]);
+                if (shift > 0) {
+                    if (memory != 0 && shift < period) {
+                        shift = m - period;
+                    }
+                    memory = 0;
+                    j += shift;
+                    continue;
+                }
+                size_t i = std::max(suffix, memory);
+                while (i < m - 1 && x[i] == y[i + j]) {
+                    ++i;
+                }
+                if (i >= m - 1) {
+                    i = suffix - 1;
+                    while (memory < i + 1 && x[i] == y[i + j]) {
+                        --i;
+                    }
+                    if (i + 1 < memory + 1 && !onMatch(j)) {
+                        return false;
+                    }
+                    j += period;
+                    memory = m - period;
+                } else {
+                    j += i - suffix + 1;
+                    memory = 0;
+                }
+            }
+        } else {
+            while (j + m <= n) {
+                size_t shift = pattern.Shift(y[j + m - 1]);
+                if (shift > 0) {
+                    j += shift;
+                    continue;
+                }
+                size_t i = suffix;
+                while (i < m - 1 && x[i] == y[i + j]) {
+                    ++i;
+                }
+                if (i >= m - 1) {
+                    i = suffix - 1;
+                    while (i != static_cast<size_t>(-1) && x[i] == y[i + j]) {
+                        --i;
+                    }
+                    if (i == static_cast<size_t>(-1) && !onMatch(j)) {
+                        return false;
+                    }
+                    j += period;
+                } else {
+                    j += i - suffix + 1;
+                }
+            }
+        }
+        return true;
+    }
+
+    // onMatch(size_t pos) -> false to stop. returns false if stopped
+    template <typename F>
+    bool Search(const char* text, size_t n, const Pattern& pattern, F onMatch) {
+        size_t m = pattern.Size();
+        if (m == 0 || m > n) {
+            return true;
+        }
+        if (m > s_TwoWayThreshold) {
+            return TwoWay(text, n, pattern, onMatch);
+        }
+        const char* x = pattern.Data();
+        size_t verify = m > 2 ? m - 2 : 0;      // first and last byte are already checked
+        size_t i = 0;
+#if defined(__AVX2__)
+        __m256i first = _mm256_set1_epi8(x[0]);
+        __m256i lastByte = _mm256_set1_epi8(x[m - 1]);
+        for (; i + m - 1 + 32 <= n; i += 32) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + m - 1));
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, lastByte))));
+            for (; mask != 0; mask &= mask - 1) {
+                size_t pos = i + static_cast<size_t>(__builtin_ctz(mask));
+                if (std::memcmp(text + pos + 1, x + 1, verify) == 0 && !onMatch(pos)) {
+                    return false;
+                }
+            }
+        }
+#elif defined(__SSE2__)
+        __m128i first = _mm_set1_epi8(x[0]);
+        __m128i lastByte = _mm_set1_epi8(x[m - 1]);
+        for (; i + m - 1 + 16 <= n; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + m - 1));
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, lastByte))));
+            for (; mask != 0; mask &= mask - 1) {
+                size_t pos = i + static_cast<size_t>(__builtin_ctz(mask));
+                if (std::memcmp(text + pos + 1, x + 1, verify) == 0 && !onMatch(pos)) {
+                    return false;
+                }
+            }
+        }
+#endif
+        for (; i + m <= n; ++i) {               // tail (or everything without SSE2)
+            if (text[i] == x[0] && text[i + m - 1] == x[m - 1] &&
+                std::memcmp(text + i + 1, x + 1, verify) == 0 && !onMatch(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+class TextEditor {
+    struct Node {
+        uint32_t buffer;
+        size_t start;
+        size_t length;      // length of this piece
+        size_t total;       // length of the subtree
+        uint32_t priority;
+        int left;
+        int right;
+    };
+
+    static const size_t s_AddBufferSize = 1 << 20;   // 1MB
+
+    std::vector<std::string> m_Buffers;     // [0] original, [1~] add buffers
+    std::vector<Node> m_Nodes;              // [0] is the null node
+    std::vector<int> m_FreeNodes;
+    int m_Root = 0;
+    uint32_t m_Seed = 2463534242u;
+
+    size_t m_SelectBegin = 0;
+    size_t m_SelectEnd = 0;
+
+public:
+    explicit TextEditor(std::string text = std::string()) {
+        m_Nodes.push_back(Node());          // null node, total == 0
+        m_Buffers.push_back(std::move(text));
+        if (!m_Buffers[0].empty()) {
+            m_Root = NewNode(0, 0, m_Buffers[0].size());
+        }
+    }
+
+    size_t Size() const { return m_Nodes[m_Root].total; }
+
+    // [begin, end) - like 1_2_naming.cpp's Select(0, 3)
+    void Select(size_t begin, size_t end) {
+        m_SelectBegin = std::min(begin, Size());
+        m_SelectEnd = std::min(std::max(begin, end), Size());
+    }
+
+    void Remove() {
+        Remove(m_SelectBegin, m_SelectEnd - m_SelectBegin);
+        m_SelectEnd = m_SelectBegin;
+    }
+
+    void Insert(size_t pos, const char* text, size_t length) {
+        if (length == 0) {
+            return;
+        }
+        pos = std::min(pos, Size());
+        uint32_t buffer;
+        size_t start;
+        Append(text, length, buffer, start);
+
+        int left, right;
+        Split(m_Root, pos, left, right);
+        int rightmost = Rightmost(left);
+        if (rightmost != 0 && m_Nodes[rightmost].buffer == buffer &&
+            m_Nodes[rightmost].start + m_Nodes[rightmost].length == start) {
+            // typing at the end of the last insert: grow that piece instead of adding one
+            m_Root = Merge(GrowRightmost(left, length), right);
+        } else {
+            m_Root = Merge(Merge(left, NewNode(buffer, start, length)), right);
+        }
+    }
+
+    void Insert(size_t pos, const std::string& text) { Insert(pos, text.data(), text.size()); }
+
+    void Remove(size_t pos, size_t length) {
+        pos = std::min(pos, Size());
+        length = std::min(length, Size() - pos);
+        if (length == 0) {
+            return;
+        }
+        int left, middle, right;
+        Split(m_Root, pos, left, middle);
+        Split(middle, length, middle, right);
+        FreeTree(middle);
+        m_Root = Merge(left, right);
+    }
+
+    char At(size_t pos) const {
+        int t = m_Root;
+        while (true) {
+            const Node& n = m_Nodes[t];
+            size_t leftTotal = m_Nodes[n.left].total;
+            if (pos < leftTotal) {
+                t = n.left;
+            } else if (pos < leftTotal + n.length) {
+                return m_Buffers[n.buffer][n.start + pos - leftTotal];
+            } else {
+                pos -= leftTotal + n.length;
+                t = n.right;
+            }
+        }
+    }
+
+    size_t PieceCount() const { return m_Nodes.size() - 1 - m_FreeNodes.size(); }
+
+    // f(const char* data, size_t length, size_t offset) -> false to stop, for every piece
+    //      in document order starting at from (the first piece is cut at from)
+    template <typename F>
+    void ForEachPiece(size_t from, F f) const {
+        struct Pending {
+            int node;
+            size_t offset;          // document offset of the node's piece
+        };
+        std::vector<Pending> stack; // no recursion, the treap can be ~40 deep on big docs
+
+        // seek: the ancestors we went left from are the pieces that come after `from`
+        int t = m_Root;
+        size_t base = 0;
+        while (t != 0) {
+            const Node& n = m_Nodes[t];
+            size_t leftTotal = m_Nodes[n.left].total;
+            if (from < base + leftTotal) {
+                stack.push_back({t, base + leftTotal});
+                t = n.left;
+            } else if (from < base + leftTotal + n.length) {
+                stack.push_back({t, base + leftTotal});
+                break;
+            } else {
+                base += leftTotal + n.length;
+                t = n.right;
+            }
+        }
+
+        while (!stack.empty()) {
+            Pending p = stack.back();
+            stack.pop_back();
+            const Node& n = m_Nodes[p.node];
+            size_t skip = from > p.offset ? from - p.offset : 0;
+            if (!f(m_Buffers[n.buffer].data() + n.start + skip, n.length - skip, p.offset + skip)) {
+                return;
+            }
+            size_t offset = p.offset + n.length;
+            for (int r = n.right; r != 0; r = m_Nodes[r].left) {
+                stack.push_back({r, offset + m_Nodes[m_Nodes[r].left].total});
+            }
+        }
+    }
+
+    // first match at or after from, npos if none
+    size_t Find(const std::string& pattern, size_t from = 0) const {
+        size_t found = std::string::npos;
+        FindEach(TextSearch::Pattern(pattern), from, [&found](size_t pos) {
+            found = pos;
+            return false;
+        });
+        return found;
+    }
+
+    // every (also overlapping) match
+    std::vector<size_t> FindAll(const std::string& pattern) const {
+        std::vector<size_t> found;
+        FindEach(TextSearch::Pattern(pattern), 0, [&found](size_t pos) {
+            found.push_back(pos);
+            return true;
+        });
+        return found;
+    }
+
+    // Searches every piece in place. Matches that cross piece boundaries are found in a small
+    //      seam buffer: the last m - 1 chars seen so far + the first m - 1 chars of the next piece,
+    //      so at most 2m bytes are copied per piece and the document is never joined.
+    template <typename F>
+    void FindEach(const TextSearch::Pattern& pattern, size_t from, F onMatch) const {
+        size_t m = pattern.Size();
+        if (m == 0) {
+            return;
+        }
+        std::string carry;          // last (up to) m - 1 chars before the current piece
+        std::string seam;
+        size_t carryOffset = from;  // document offset of carry[0]
+        ForEachPiece(from, [&](const char* data, size_t length, size_t offset) {
+            if (!carry.empty()) {
+                seam.assign(carry);
+                seam.append(data, std::min(length, m - 1));
+                bool more = TextSearch::Search(seam.data(), seam.size(), pattern, [&](size_t pos) {
+                    return pos >= carry.size() || onMatch(carryOffset + pos);   // pos >= carry: inside this piece, found below
+                });
+                if (!more) {
+                    return false;
+                }
+            }
+            if (!TextSearch::Search(data, length, pattern, [&](size_t pos) { return onMatch(offset + pos); })) {
+                return false;
+            }
+            if (length >= m - 1) {
+                carry.assign(data + length - (m - 1), m - 1);
+            } else {
+                carry.append(data, length);
+                if (carry.size() > m - 1) {
+                    carry.erase(0, carry.size() - (m - 1));
+                }
+            }
+            carryOffset = offset + length - carry.size();
+            return true;
+        });
+    }
+
+    std::string Text() const {
+        std::string text;
+        text.reserve(Size());
+        ForEachPiece(0, [&text](const char* data, size_t length, size_t) {
+            text.append(data, length);
+            return true;
+        });
+        return text;
+    }
+
+private:
+    uint32_t Random() {
+        m_Seed ^= m_Seed << 13;
+        m_Seed ^= m_Seed >> 17;
+        m_Seed ^= m_Seed << 5;
+        return m_Seed;
+    }
+
+    // copies the typed text to the end of an add buffer. add buffers never grow past their
+    //      reserved capacity, so pieces pointing into them stay valid
+    void Append(const char* text, size_t length, uint32_t& buffer, size_t& start) {
+        std::string* add = m_Buffers.size() > 1 ? &m_Buffers.back() : nullptr;
+        if (add == nullptr || add->capacity() - add->size() < length) {
+            m_Buffers.push_back(std::string());
+            m_Buffers.back().reserve(std::max(length, s_AddBufferSize));
+            add = &m_Buffers.back();
+        }
+        buffer = static_cast<uint32_t>(m_Buffers.size() - 1);
+        start = add->size();
+        add->append(text, length);
+    }
+
+    int NewNode(uint32_t buffer, size_t start, size_t length) {
+        int t;
+        if (!m_FreeNodes.empty()) {
+            t = m_FreeNodes.back();
+            m_FreeNodes.pop_back();
+        } else {
+            t = static_cast<int>(m_Nodes.size());
+            m_Nodes.push_back(Node());
+        }
+        Node& n = m_Nodes[t];
+        n.buffer = buffer;
+        n.start = start;
+        n.length = length;
+        n.total = length;
+        n.priority = Random();
+        n.left = 0;
+        n.right = 0;
+        return t;
+    }
+
+    void FreeTree(int t) {
+        if (t == 0) {
+            return;
+        }
+        FreeTree(m_Nodes[t].left);
+        FreeTree(m_Nodes[t].right);
+        m_FreeNodes.push_back(t);
+    }
+
+    void Update(int t) {
+        Node& n = m_Nodes[t];
+        n.total = m_Nodes[n.left].total + n.length + m_Nodes[n.right].total;
+    }
+
+    int Rightmost(int t) const {
+        while (t != 0 && m_Nodes[t].right != 0) {
+            t = m_Nodes[t].right;
+        }
+        return t;
+    }
+
+    int GrowRightmost(int t, size_t length) {
+        if (m_Nodes[t].right != 0) {
+            m_Nodes[t].right = GrowRightmost(m_Nodes[t].right, length);
+        } else {
+            m_Nodes[t].length += length;
+        }
+        Update(t);
+        return t;
+    }
+
+    // first pos characters -> left, the rest -> right. a piece crossing pos is cut in two
+    void Split(int t, size_t pos, int& left, int& right) {
+        if (t == 0) {
+            left = right = 0;
+            return;
+        }
+        size_t leftTotal = m_Nodes[m_Nodes[t].left].total;
+        size_t length = m_Nodes[t].length;
+        if (pos <= leftTotal) {
+            int l;
+            Split(m_Nodes[t].left, pos, left, l);
+            m_Nodes[t].left = l;
+            Update(t);
+            right = t;
+        } else if (pos >= leftTotal + length) {
+            int r;
+            Split(m_Nodes[t].right, pos - leftTotal - length, r, right);
+            m_Nodes[t].right = r;
+            Update(t);
+            left = t;
+        } else {
+            size_t offset = pos - leftTotal;
+            int tail = NewNode(m_Nodes[t].buffer, m_Nodes[t].start + offset, length - offset); // (may move m_Nodes)
+            int oldRight = m_Nodes[t].right;
+            m_Nodes[t].length = offset;
+            m_Nodes[t].right = 0;
+            Update(t);
+            left = t;
+            right = Merge(tail, oldRight);
+        }
+    }
+
+    int Merge(int left, int right) {
+        if (left == 0 || right == 0) {
+            return left != 0 ? left : right;
+        }
+        if (m_Nodes[left].priority > m_Nodes[right].priority) {
+            m_Nodes[left].right = Merge(m_Nodes[left].right, right);
+            Update(left);
+            return left;
+        }
+        m_Nodes[right].left = Merge(left, m_Nodes[right].left);
+        Update(right);
+        return right;
+    }
+};
+
+namespace {
+    uint32_t g_Seed = 12345;
+    uint32_t Random() {
+        g_Seed = g_Seed * 1103515245u + 12345u;
+        return g_Seed >> 8;
+    }
+
+    // FindAll/Find on the fragmented editor vs a std::string::find loop on the joined text
+    bool CheckFind(const TextEditor& editor, const std::string& naive) {
+        int patterns = 0;
+        for (size_t length : {1, 2, 3, 5, 8, 17, 31, 64, 65, 100, 300}) {
+            for (int k = 0; k < 20 && naive.size() >= length; ++k) {
+                // mostly cut out of the text so there are matches across piece boundaries
+                std::string pattern = naive.substr(Random() % (naive.size() - length + 1), length);
+                if (k % 4 == 3) {
+                    pattern[Random() % length] = 'A';
+                }
+                std::vector<size_t> expected;
+                for (size_t pos = naive.find(pattern); pos != std::string::npos; pos = naive.find(pattern, pos + 1)) {
+                    expected.push_back(pos);
+                }
+                size_t from = Random() % (naive.size() + 1);
+                if (editor.FindAll(pattern) != expected || editor.Find(pattern, from) != naive.find(pattern, from)) {
+                    std::cerr << "find mismatch, pattern length " << length << std::endl;
+                    return false;
+                }
+                ++patterns;
+            }
+        }
+        std::cout << patterns << " patterns found ok" << std::endl;
+        return true;
+    }
+
+    // same edits on a TextEditor and a std::string, compared every 1000 steps
+    bool Check(int edits) {
+        std::string naive = "The quick brown fox jumps over the lazy dog\n";
+        TextEditor editor(naive);
+        for (int i = 0; i < edits; ++i) {
+            size_t pos = naive.empty() ? 0 : Random() % (naive.size() + 1);
+            if (Random() % 3 != 0) {
+                std::string text(1 + Random() % 8, static_cast<char>('a' + Random() % 26));
+                naive.insert(pos, text);
+                editor.Insert(pos, text);
+            } else {
+                size_t length = Random() % 12;
+                naive.erase(std::min(pos, naive.size()), length);
+                editor.Remove(pos, length);
+            }
+            if (i % 1000 == 0 || i == edits - 1) {
+                size_t at = naive.empty() ? 0 : Random() % naive.size();
+                if (editor.Text() != naive || (!naive.empty() && editor.At(at) != naive[at])) {
+                    std::cerr << "mismatch after " << i + 1 << " edits" << std::endl;
+                    return false;
+                }
+            }
+        }
+        std::cout << edits << " edits ok, " << editor.Size() << " chars in "
+                  << editor.PieceCount() << " pieces" << std::endl;
+        return CheckFind(editor, naive);
+    }
+
+    // edits: 2/3 short inserts, 1/3 short removes at random positions
+    template <typename Doc, typename InsertFunc, typename RemoveFunc>
+    double RunEdits(Doc& doc, size_t size, int edits, InsertFunc insert, RemoveFunc remove) {
+        typedef std::chrono::steady_clock Clock;
+        g_Seed = 999;
+        Clock::time_point t0 = Clock::now();
+        for (int i = 0; i < edits; ++i) {
+            size_t pos = (static_cast<size_t>(Random()) << 24 ^ Random()) % (size + 1);
+            if (Random() % 3 != 0) {
+                insert(doc, pos, "hello");
+                size += 5;
+            } else {
+                size_t length = std::min<size_t>(5, size - pos);
+                remove(doc, pos, length);
+                size -= length;
+            }
+        }
+        return std::chrono::duration<double>(Clock::now() - t0).count();
+    }
+
+    void Bench(size_t megabytes, int edits) {
+        std::string text(megabytes << 20, 'x');
+        for (size_t i = 0; i < text.size(); i += 64) {
+            text[i] = '\n';
+        }
+
+        std::string naive = text;
+        int naiveEdits = std::min(edits, static_cast<int>(std::max<size_t>(100, 200000 / std::max<size_t>(1, megabytes))));
+        double naiveSec = RunEdits(naive, text.size(), naiveEdits,
+            [](std::string& s, size_t pos, const char* t) { s.insert(pos, t); },
+            [](std::string& s, size_t pos, size_t length) { s.erase(pos, length); });
+
+        TextEditor editor(std::move(text));
+        double editorSec = RunEdits(editor, editor.Size(), edits,
+            [](TextEditor& e, size_t pos, const char* t) { e.Insert(pos, t, std::strlen(t)); },
+            [](TextEditor& e, size_t pos, size_t length) { e.Remove(pos, length); });
+
+        double naiveNs = naiveSec * 1e9 / naiveEdits;
+        double editorNs = editorSec * 1e9 / edits;
+        std::printf("%5zu MB | std::string %10.0f ns/edit (%d edits) | piece table %8.0f ns/edit (%d edits, %zu pieces) | x%.0f\n",
+                    megabytes, naiveNs, naiveEdits, editorNs, edits, editor.PieceCount(), naiveNs / editorNs);
+    }
+
+    // log-like document cut into many pieces, rare pattern: GB/s of std::string::find on the
+    //      joined text vs FindAll on the pieces
+    void BenchFind(size_t megabytes, const std::string& pattern) {
+        typedef std::chrono::steady_clock Clock;
+        const char* words[] = {"INFO ", "WARN ", "request ", "served ", "in ", "12ms ", "user=42 ", "path=/api/v1 "};
+        std::string text;
+        text.reserve(megabytes << 20);
+        while (text.size() < (megabytes << 20)) {
+            text += words[Random() % 8];
+            if (Random() % 12 == 0) {
+                text += '\n';
+            }
+        }
+        TextEditor editor(text);
+        for (int i = 0; i < 10000; ++i) {      // ~10000 pieces
+            size_t pos = (static_cast<size_t>(Random()) << 24 ^ Random()) % editor.Size();
+            editor.Insert(pos, Random() % 500 == 0 ? pattern : std::string("x"));
+        }
+        std::string joined = editor.Text();
+        double gb = joined.size() / (1024.0 * 1024.0 * 1024.0);
+
+        Clock::time_point t0 = Clock::now();
+        size_t naiveCount = 0;
+        for (size_t pos = joined.find(pattern); pos != std::string::npos; pos = joined.find(pattern, pos + 1)) {
+            ++naiveCount;
+        }
+        Clock::time_point t1 = Clock::now();
+        size_t count = editor.FindAll(pattern).size();
+        Clock::time_point t2 = Clock::now();
+
+        double naiveSec = std::chrono::duration<double>(t1 - t0).count();
+        double sec = std::chrono::duration<double>(t2 - t1).count();
+        std::printf("%5zu MB, pattern %3zu chars | std::string::find %6.2f GB/s | FindAll %6.2f GB/s (%zu pieces) | x%.1f %s\n",
+                    megabytes, pattern.size(), gb / naiveSec, gb / sec, editor.PieceCount(), naiveSec / sec,
+                    count == naiveCount ? "" : "MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+        return Check(argc > 2 ? std::atoi(argv[2]) : 100000) ? 0 : 1;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench-find") == 0) {
+        size_t megabytes = argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 256;
+        BenchFind(megabytes, "timeout");
+        BenchFind(megabytes, "connection reset by peer");
+        BenchFind(megabytes, std::string("request ") + std::string(80, 'z') + " failed");
+        return 0;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        if (argc > 2) {
+            Bench(static_cast<size_t>(std::atoll(argv[2])), argc > 3 ? std::atoi(argv[3]) : 1000000);
+        } else {
+            for (size_t megabytes : {1, 16, 256}) {
+                Bench(megabytes, 1000000);
+            }
+        }
+        return 0;
+    }
+
+    TextEditor textEditor("abcdef");
+    textEditor.Select(0, 3);            // way better
+    textEditor.Remove();
+    std::cout << textEditor.Text() << std::endl;    // def
+    return 0;
+}
@@ -0,0 +1,316 @@
+/**
+ *          SoAVector
+ * --------------------------------------------------
+ * 1_3_types.cpp has
+ *      typedef struct {int a; int b;} myData, *pMyData;
+ * Kept in a std::vector<myData> (array of structs, AoS) the memory looks like
+ *      a b a b a b a b ...
+ * so a loop that only reads a still pulls every b through the cache.
+ *
+ * Struct of arrays (SoA):
+ *      a a a a ...     <- one contiguous, 64 byte aligned column per field
+ *      b b b b ...
+ *      a scan over one field touches only that column and vectorizes trivially.
+ *      v[i] still gives something that looks like a myData (a proxy)
+ *
+ * C++ can't list the fields of a struct by itself, so a type opts in with SoAFields<T>:
+ *      template <> struct SoAFields<myData> {
+ *          static constexpr auto members = std::make_tuple(&myData::a, &myData::b);
+ *      };
+ *
+ * Modern C++:
+ *  C++17~ -> operator new with align_val_t was added for over-aligned allocations
+ *
+ * Usage:
+ *      1_3_2_soaVector                 // small example
+ *      1_3_2_soaVector --bench [N]     // field scan / full record, std::vector<myData> vs SoAVector
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+typedef struct {int a; int b;} myData, *pMyData;
+
+// specialize with a tuple of member pointers
+template <class T>
+struct SoAFields;
+
+template <>
+struct SoAFields<myData> {
+    static constexpr auto members = std::make_tuple(&myData::a, &myData::b);
+};
+
+namespace SoADetail {
+    template <class M>
+    struct MemberType;
+    template <class T, class F>
+    struct MemberType<F T::*> {
+        typedef F Type;
+    };
+
+    template <class T>
+    using Members = std::remove_const_t<decltype(SoAFields<T>::members)>;
+
+    template <class T, size_t I>
+    using FieldType = typename MemberType<std::tuple_element_t<I, Members<T>>>::Type;
+
+    template <class T, class Seq>
+    struct ColumnTuple;
+    template <class T, size_t... I>
+    struct ColumnTuple<T, std::index_sequence<I...>> {
+        typedef std::tuple<FieldType<T, I>*...> Type;
+    };
+}
+
+template <class T>
+class SoAVector {
+public:
+    static const size_t s_FieldCount = std::tuple_size<SoADetail::Members<T>>::value;
+    static const size_t s_Alignment = 64;
+
+private:
+    typedef std::make_index_sequence<s_FieldCount> Indices;
+    typedef typename SoADetail::ColumnTuple<T, Indices>::Type Columns;
+
+    Columns m_Columns{};
+    size_t m_Size = 0;
+    size_t m_Capacity = 0;
+
+public:
+    // v[i] - reads and writes go straight to the columns
+    class Reference {
+        SoAVector& m_Owner;
+        size_t m_Index;
+    public:
+        Reference(SoAVector& owner, size_t index) : m_Owner(owner), m_Index(index) {}
+
+        operator T() const { return m_Owner.Load(m_Index); }
+        Reference& operator =(const T& value) {
+            m_Owner.Store(m_Index, value);
+            return *this;
+        }
+        Reference& operator =(const Reference& other) { return *this = static_cast<T>(other); }
+
+        // v[i].Get<&myData::a>() - one field, by reference
+        template <auto Member>
+        auto& Get() const { return m_Owner.template Column<Member>()[m_Index]; }
+    };
+
+    SoAVector() = default;
+    explicit SoAVector(size_t size) { resize(size); }
+    SoAVector(const SoAVector&) = delete;
+    SoAVector& operator =(const SoAVector&) = delete;
+    ~SoAVector() { Free(m_Columns); }
+
+    size_t size() const { return m_Size; }
+    bool empty() const { return m_Size == 0; }
+
+    Reference operator [](size_t index) { return Reference(*this, index); }
+    T operator [](size_t index) const { return Load(index); }
+
+    void push_back(const T& value) {
+        if (m_Size == m_Capacity) {
+            reserve(m_Capacity == 0 ? 16 : m_Capacity * 2);
+        }
+        Store(m_Size++, value);
+    }
+
+    void resize(size_t size) {          // new elements are zero
+        reserve(size);
+        ForEachColumn([this, size](auto* column) {
+            if (size > m_Size) {
+                std::memset(column + m_Size, 0, (size - m_Size) * sizeof(*column));
+            }
+        });
+        m_Size = size;
+    }
+
+    void reserve(size_t capacity) {
+        if (capacity <= m_Capacity) {
+            return;
+        }
+        Columns columns = Allocate(capacity, Indices());
+        Copy(columns, m_Columns, m_Size, Indices());
+        Free(m_Columns);
+        m_Columns = columns;
+        m_Capacity = capacity;
+    }
+
+    // the raw column of a field, 64 byte aligned
+    template <size_t I>
+    SoADetail::FieldType<T, I>* ColumnAt() { return std::get<I>(m_Columns); }
+    template <size_t I>
+    const SoADetail::FieldType<T, I>* ColumnAt() const { return std::get<I>(m_Columns); }
+
+    template <auto Member>
+    auto* Column() {
+        constexpr size_t index = IndexOf<Member>(Indices());
+        static_assert(index < s_FieldCount, "member is not listed in SoAFields<T>::members");
+        return ColumnAt<(index < s_FieldCount ? index : 0)>();     // only the static_assert reports
+    }
+    template <auto Member>
+    const auto* Column() const {
+        constexpr size_t index = IndexOf<Member>(Indices());
+        static_assert(index < s_FieldCount, "member is not listed in SoAFields<T>::members");
+        return ColumnAt<(index < s_FieldCount ? index : 0)>();     // only the static_assert reports
+    }
+
+private:
+    static_assert(std::is_trivially_copyable<T>::value, "SoAVector copies fields with memcpy");
+
+    // s_FieldCount if Member is not listed
+    template <auto Member, size_t... I>
+    static constexpr size_t IndexOf(std::index_sequence<I...>) {
+        size_t index = 0;
+        bool found = ((Same(std::get<I>(SoAFields<T>::members), Member) ? (index = I, true) : false) || ...);
+        return found ? index : s_FieldCount;
+    }
+    template <class A, class B>
+    static constexpr bool Same(A a, B b) {
+        if constexpr (std::is_same<A, B>::value) {
+            return a == b;
+        } else {
+            return false;
+        }
+    }
+
+    T Load(size_t index) const { return Load(index, Indices()); }
+    template <size_t... I>
+    T Load(size_t index, std::index_sequence<I...>) const {
+        T value;
+        ((value.*std::get<I>(SoAFields<T>::members) = std::get<I>(m_Columns)[index]), ...);
+        return value;
+    }
+
+    void Store(size_t index, const T& value) { Store(index, value, Indices()); }
+    template <size_t... I>
+    void Store(size_t index, const T& value, std::index_sequence<I...>) {
+        ((std::get<I>(m_Columns)[index] = value.*std::get<I>(SoAFields<T>::members)), ...);
+    }
+
+    template <class F>
+    void ForEachColumn(F f) {
+        std::apply([&f](auto*... column) { (f(column), ...); }, m_Columns);
+    }
+
+    template <size_t... I>
+    static Columns Allocate(size_t capacity, std::index_sequence<I...>) {
+        return Columns(static_cast<SoADetail::FieldType<T, I>*>(
+            ::operator new(capacity * sizeof(SoADetail::FieldType<T, I>), std::align_val_t(s_Alignment)))...);
+    }
+
+    template <size_t... I>
+    static void Copy(Columns& to, const Columns& from, size_t size, std::index_sequence<I...>) {
+        ((size != 0 ? (void)std::memcpy(std::get<I>(to), std::get<I>(from), size * sizeof(*std::get<I>(to))) : (void)0), ...);
+    }
+
+    static void Free(Columns& columns) {
+        std::apply([](auto*... column) {
+            ((column != nullptr ? ::operator delete(column, std::align_val_t(s_Alignment)) : (void)0), ...);
+        }, columns);
+    }
+};
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double Seconds(Clock::time_point from) {
+        return std::chrono::duration<double>(Clock::now() - from).count();
+    }
+
+    void Bench(size_t count) {
+        std::vector<myData> aos(count);
+        SoAVector<myData> soa(count);
+        for (size_t i = 0; i < count; ++i) {
+            myData d = {static_cast<int>(i & 0xFFFF), static_cast<int>(i % 7)};
+            aos[i] = d;
+            soa[i] = d;
+        }
+        const int repeat = 10;
+        long long check[4] = {};
+        double sec[4];
+
+        // single field scan: sum of a
+        Clock::time_point t = Clock::now();
+        for (int r = 0; r < repeat; ++r) {
+            long long sum = 0;
+            for (size_t i = 0; i < count; ++i) {
+                sum += aos[i].a;
+            }
+            check[0] += sum;
+        }
+        sec[0] = Seconds(t);
+
+        t = Clock::now();
+        for (int r = 0; r < repeat; ++r) {
+            const int* a = soa.Column<&myData::a>();
+            long long sum = 0;
+            for (size_t i = 0; i < count; ++i) {
+                sum += a[i];
+            }
+            check[1] += sum;
+        }
+        sec[1] = Seconds(t);
+
+        // full record: sum of a * b, the SoA side through the myData proxy
+        t = Clock::now();
+        for (int r = 0; r < repeat; ++r) {
+            long long sum = 0;
+            for (size_t i = 0; i < count; ++i) {
+                sum += static_cast<long long>(aos[i].a) * aos[i].b;
+            }
+            check[2] += sum;
+        }
+        sec[2] = Seconds(t);
+
+        t = Clock::now();
+        for (int r = 0; r < repeat; ++r) {
+            const SoAVector<myData>& view = soa;
+            long long sum = 0;
+            for (size_t i = 0; i < count; ++i) {
+                myData d = view[i];
+                sum += static_cast<long long>(d.a) * d.b;
+            }
+            check[3] += sum;
+        }
+        sec[3] = Seconds(t);
+
+        double n = static_cast<double>(count) * repeat;
+        std::printf("%11zu records | field scan  vector %6.3f ns  SoA %6.3f ns  x%.2f | full record  vector %6.3f ns  SoA %6.3f ns  x%.2f %s\n",
+                    count, sec[0] * 1e9 / n, sec[1] * 1e9 / n, sec[0] / sec[1],
+                    sec[2] * 1e9 / n, sec[3] * 1e9 / n, sec[2] / sec[3],
+                    check[0] == check[1] && check[2] == check[3] ? "" : "MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        if (argc > 2) {
+            Bench(static_cast<size_t>(std::atoll(argv[2])));
+        } else {
+            for (size_t count : {1000, 100000, 10000000}) {
+                Bench(count);
+            }
+        }
+        return 0;
+    }
+
+    SoAVector<myData> v;
+    v.push_back(myData{10, 20});
+    v.push_back(myData{30, 40});
+    v[1].Get<&myData::a>() = 31;        // one field, by reference
+
+    myData d = v[1];                    // whole record through the proxy
+    std::cout << d.a << " " << d.b << std::endl;                        // 31 40
+    std::cout << v.Column<&myData::b>()[0] << std::endl;               // 20
+    std::cout << (reinterpret_cast<size_t>(v.ColumnAt<0>()) % 64 == 0) << std::endl;   // 1 (aligned)
+    return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ *          Batch Func
+ * --------------------------------------------------
+ * 1_3_types.cpp calls through a function pointer one pair at a time:
+ *      typedef int (*Func)(int, int);
+ *      int f(int a, int b) {return a + b;}
+ *      Func func = f;
+ *
+ * Over big arrays the call itself is the cost: an indirect call per element,
+ *      nothing inlined, so nothing vectorized.
+ *
+ * Apply(f, a, b, out, n) -> out[i] = f(a[i], b[i])
+ *      callable object (lambda, std::plus, ...) -> template, inlined, auto-vectorized
+ *      Apply<f>(...)                             -> the pointer is a template argument, same thing
+ *      Func at runtime                           -> known functions are looked up once and sent to
+ *                                                   their inlined loop, anything else is an indirect loop
+ *
+ * Usage:
+ *      1_3_3_batchFunc                 // small example
+ *      1_3_3_batchFunc --bench [N ...] // indirect vs inlined, default 1K ~ 10M
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+typedef int (*Func)(int, int);      // function pointer typedef
+
+int f(int a, int b) {return a + b;} // definition of the function
+int Sub(int a, int b) {return a - b;}
+int Mul(int a, int b) {return a * b;}
+
+namespace Batch {
+    // any callable: the compiler sees the body, inlines it and vectorizes the loop
+    template <class F>
+    void Apply(F func, const int* a, const int* b, int* out, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = func(a[i], b[i]);
+        }
+    }
+
+    // function known at compile time: Apply<f>(a, b, out, n)
+    template <Func F>
+    void Apply(const int* a, const int* b, int* out, size_t n) {
+        Apply([](int x, int y) { return F(x, y); }, a, b, out, n);
+    }
+
+    // pointer only known at runtime: one indirect call per element
+#if defined(__GNUC__)
+    __attribute__((noinline))
+#endif
+    void ApplyIndirect(Func func, const int* a, const int* b, int* out, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = func(a[i], b[i]);
+        }
+    }
+
+    // Func at runtime: check the functions we have inlined loops for, once per batch
+    //      (not per element), otherwise fall back to the indirect loop
+    inline void Apply(Func func, const int* a, const int* b, int* out, size_t n) {
+        struct Known {
+            Func func;
+            void (*apply)(const int*, const int*, int*, size_t);
+        };
+        static const Known known[] = {
+            {&f, &Apply<&f>},
+            {&Sub, &Apply<&Sub>},
+            {&Mul, &Apply<&Mul>},
+        };
+        for (const Known& k : known) {
+            if (k.func == func) {
+                k.apply(a, b, out, n);
+                return;
+            }
+        }
+        ApplyIndirect(func, a, b, out, n);
+    }
+}
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    int Xor(int a, int b) {return a ^ b;}  // not in the known list
+
+    // ns per element, repeated so small sizes are measurable
+    template <class Run>
+    double Measure(size_t n, Run run) {
+        size_t repeat = std::max<size_t>(1, 50000000 / n);
+        Clock::time_point t = Clock::now();
+        for (size_t r = 0; r < repeat; ++r) {
+            run();
+        }
+        return std::chrono::duration<double>(Clock::now() - t).count() * 1e9 / (static_cast<double>(n) * repeat);
+    }
+
+    void Bench(size_t n) {
+        std::vector<int> a(n), b(n), out1(n), out2(n), out3(n);
+        for (size_t i = 0; i < n; ++i) {
+            a[i] = static_cast<int>(i);
+            b[i] = static_cast<int>(i * 7 + 3);
+        }
+        volatile Func opaque = f;   // hide the pointer from the optimizer, like a real callback
+        Func func = opaque;
+
+        double indirect = Measure(n, [&]() { Batch::ApplyIndirect(func, a.data(), b.data(), out1.data(), n); });
+        double dispatched = Measure(n, [&]() { Batch::Apply(func, a.data(), b.data(), out2.data(), n); });
+        double inlined = Measure(n, [&]() { Batch::Apply(std::plus<int>(), a.data(), b.data(), out3.data(), n); });
+
+        volatile Func other = Xor;
+        double unknown = Measure(n, [&]() { Batch::Apply(other, a.data(), b.data(), out1.data(), n); });
+
+        bool same = out2 == out3;
+        Batch::ApplyIndirect(func, a.data(), b.data(), out1.data(), n);
+        same = same && out1 == out3;
+        std::printf("%11zu | indirect %6.3f ns | Func dispatched %6.3f ns | std::plus inlined %6.3f ns | unknown Func %6.3f ns | x%.1f %s\n",
+                    n, indirect, dispatched, inlined, unknown, indirect / dispatched, same ? "" : "MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        std::vector<size_t> sizes;
+        for (int i = 2; i < argc; ++i) {
+            sizes.push_back(static_cast<size_t>(std::atoll(argv[i])));
+        }
+        if (sizes.empty()) {
+            sizes = {1000, 100000, 10000000};   // (100000000 needs ~1.6GB)
+        }
+        for (size_t n : sizes) {
+            Bench(n);
+        }
+        return 0;
+    }
+
+    int a[4] = {1, 2, 3, 4};
+    int b[4] = {10, 20, 30, 40};
+    int out[4];
+
+    Func func = f;                                  // saving the function pointer
+    Batch::Apply(func, a, b, out, 4);               // known -> inlined loop
+    std::cout << out[0] << " " << out[3] << std::endl;  // 11 44
+
+    Batch::Apply<Mul>(a, b, out, 4);                // compile time pointer
+    std::cout << out[0] << " " << out[3] << std::endl;  // 10 160
+
+    Batch::Apply([](int x, int y) { return x > y ? x : y; }, a, b, out, 4);  // lambda
+    std::cout << out[0] << " " << out[3] << std::endl;  // 10 40
+    return 0;
+}
@@ -0,0 +1,328 @@
+/***
+ *              Trace Scope
+ *  1_4_effective.cpp keeps the effective range small with { } blocks:
+ *      void f() {
+ *          int a; int b;       // a~b usage codes
+ *          { int c; int d; }   // c & d usage codes
+ *          { int e; int f; }   // e & f usage codes
+ *      }
+ *  Those blocks are also exactly what we want to time.
+ *
+ *  TRACE_SCOPE("name") is an RAII marker for such a block:
+ *      constructor reads the TSC, destructor reads it again and pushes {name, begin, end}
+ *      into the ring buffer of the current thread (no lock, no allocation, no syscall)
+ *  A background thread drains all ring buffers and writes a Chrome trace-event JSON file
+ *      (open it in chrome://tracing or ui.perfetto.dev)
+ *  If a ring is full the event is dropped and counted - tracing never blocks the hot path
+ *
+ *  Modern C++:
+ *      C++11~ -> thread_local was added, so every thread gets its own buffer for free
+ *      C++11~ -> atomic was added for the lock-free single producer/single consumer ring
+ *
+ *  Usage:
+ *      1_4_2_traceScope [trace.json]           // traces f() from 1_4_effective.cpp
+ *      1_4_2_traceScope --bench [N [file]]     // cost per TRACE_SCOPE
+ * */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#define TRACE_HAS_TSC 1
+#endif
+
+namespace Trace {
+    inline uint64_t Now() {
+#if defined(TRACE_HAS_TSC)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    struct Event {
+        const char* name;       // string literal, never copied
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    // one producer (the owning thread), one consumer (the flusher)
+    class Ring {
+    public:
+        static const size_t s_Capacity = 1 << 16;   // power of 2
+
+    private:
+        alignas(64) std::atomic<uint64_t> m_Head{0};    // written by the producer
+        alignas(64) std::atomic<uint64_t> m_Tail{0};    // written by the consumer
+        alignas(64) std::atomic<uint64_t> m_Dropped{0}; // written by the producer, read by the report
+        Event m_Events[s_Capacity];
+
+    public:
+        const int m_ThreadId;
+
+        explicit Ring(int threadId) : m_ThreadId(threadId) {}
+
+        void Push(const Event& event) {
+            uint64_t head = m_Head.load(std::memory_order_relaxed);
+            if (head - m_Tail.load(std::memory_order_acquire) == s_Capacity) {
+                m_Dropped.store(m_Dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+            m_Events[head & (s_Capacity - 1)] = event;
+            m_Head.store(head + 1, std::memory_order_release);
+        }
+
+        // f(const Event&) for everything pushed so far
+        template <class F>
+        void Drain(F f) {
+            uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+            uint64_t head = m_Head.load(std::memory_order_acquire);
+            for (; tail != head; ++tail) {
+                f(m_Events[tail & (s_Capacity - 1)]);
+            }
+            m_Tail.store(tail, std::memory_order_release);
+        }
+
+        uint64_t Dropped() const { return m_Dropped.load(std::memory_order_relaxed); }
+        uint64_t Pending() const {
+            return m_Head.load(std::memory_order_acquire) - m_Tail.load(std::memory_order_acquire);
+        }
+    };
+
+    // owns the rings and the flusher thread
+    class Tracer {
+        std::mutex m_Mutex;
+        std::vector<std::unique_ptr<Ring>> m_Rings;     // rings outlive their threads
+        std::thread m_Flusher;
+        std::atomic<bool> m_Running{false};
+        std::FILE* m_File = nullptr;
+        bool m_FirstEvent = true;
+        uint64_t m_Origin = 0;
+        double m_TicksPerMicrosecond = 1.0;
+
+    public:
+        static Tracer& Instance() {
+            static Tracer tracer;
+            return tracer;
+        }
+
+        ~Tracer() { Stop(); }
+
+        bool Start(const char* path) {
+            m_File = std::fopen(path, "w");
+            if (m_File == nullptr) {
+                return false;
+            }
+            std::fputs("{\"traceEvents\":[\n", m_File);
+            m_FirstEvent = true;
+            Calibrate();
+            m_Running.store(true, std::memory_order_release);
+            m_Flusher = std::thread([this]() {
+                while (m_Running.load(std::memory_order_acquire)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    Flush();
+                }
+            });
+            return true;
+        }
+
+        void Stop() {
+            if (m_File == nullptr) {
+                return;
+            }
+            m_Running.store(false, std::memory_order_release);
+            m_Flusher.join();
+            Flush();
+            std::fputs("\n]}\n", m_File);
+            std::fclose(m_File);
+            m_File = nullptr;
+        }
+
+        bool Running() const { return m_Running.load(std::memory_order_relaxed); }
+
+        uint64_t Dropped() {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            uint64_t dropped = 0;
+            for (const std::unique_ptr<Ring>& ring : m_Rings) {
+                dropped += ring->Dropped();
+            }
+            return dropped;
+        }
+
+        // plain thread_local pointer, so the hot path has no static init guard to check
+        static Ring& ThreadRing() {
+            static thread_local Ring* t_Ring = nullptr;
+            if (t_Ring == nullptr) {
+                t_Ring = Instance().Register();
+            }
+            return *t_Ring;
+        }
+
+    private:
+        Tracer() = default;
+
+        Ring* Register() {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Rings.push_back(std::make_unique<Ring>(static_cast<int>(m_Rings.size()) + 1));
+            return m_Rings.back().get();
+        }
+
+        // TSC ticks per microsecond, measured against steady_clock
+        void Calibrate() {
+            typedef std::chrono::steady_clock Clock;
+            Clock::time_point t0 = Clock::now();
+            uint64_t c0 = Now();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            uint64_t c1 = Now();
+            double us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+            m_TicksPerMicrosecond = (c1 - c0) / us;
+            m_Origin = c0;
+        }
+
+        // name as the inside of a JSON string
+        void WriteEscaped(const char* name) {
+            for (const char* c = name; *c != '\0'; ++c) {
+                if (*c == '"' || *c == '\\') {
+                    std::fputc('\\', m_File);
+                    std::fputc(*c, m_File);
+                } else if (static_cast<unsigned char>(*c) < 0x20) {
+                    std::fprintf(m_File, "\\u%04x", static_cast<unsigned>(*c));
+                } else {
+                    std::fputc(*c, m_File);
+                }
+            }
+        }
+
+        void Flush() {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            for (const std::unique_ptr<Ring>& ring : m_Rings) {
+                int tid = ring->m_ThreadId;
+                ring->Drain([this, tid](const Event& e) {
+                    double ts = static_cast<int64_t>(e.begin - m_Origin) / m_TicksPerMicrosecond;
+                    double dur = (e.end - e.begin) / m_TicksPerMicrosecond;
+                    std::fprintf(m_File, "%s{\"name\":\"", m_FirstEvent ? "" : ",\n");
+                    WriteEscaped(e.name);
+                    std::fprintf(m_File, "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}", ts, dur, tid);
+                    m_FirstEvent = false;
+                });
+            }
+            std::fflush(m_File);
+        }
+    };
+
+    class Scope {
+        const char* m_Name;
+        uint64_t m_Begin;
+    public:
+        explicit Scope(const char* name) : m_Name(name), m_Begin(Now()) {}
+        ~Scope() {
+            uint64_t end = Now();
+            Tracer::ThreadRing().Push(Event{m_Name, m_Begin, end});
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator =(const Scope&) = delete;
+    };
+}
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+// name has to be a string literal (only the pointer is stored)
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope_, __LINE__)(name)
+
+namespace {
+    volatile int g_Sink;
+
+    void f() {
+        TRACE_SCOPE("f");
+        int a = 1;
+        int b = 2;
+        // a~b usage codes
+        g_Sink = a + b;
+
+        {
+            TRACE_SCOPE("f/c~d");
+            int c = 3;
+            int d = 4;
+            // c & d usage codes
+            g_Sink = c * d;
+        }
+
+        {
+            TRACE_SCOPE("f/e~f");
+            int e = 5;
+            int f = 6;
+            // e & f usage codes
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            g_Sink = e - f;
+        }
+    }
+
+    void Bench(long long count, const char* path) {
+        typedef std::chrono::steady_clock Clock;
+        Trace::Tracer& tracer = Trace::Tracer::Instance();
+        if (!tracer.Start(path)) {
+            std::fprintf(stderr, "can't open %s\n", path);
+            return;
+        }
+
+        Clock::time_point t0 = Clock::now();
+        for (long long i = 0; i < count; ++i) {
+            g_Sink = static_cast<int>(i);
+        }
+        double empty = std::chrono::duration<double>(Clock::now() - t0).count();
+
+        // batches of half a ring, waiting for the flusher in between so nothing is dropped
+        Trace::Ring& ring = Trace::Tracer::ThreadRing();
+        double traced = 0;
+        const long long batch = Trace::Ring::s_Capacity / 2;
+        for (long long done = 0; done < count; done += batch) {
+            Clock::time_point b0 = Clock::now();
+            for (long long i = done; i < done + batch && i < count; ++i) {
+                TRACE_SCOPE("bench");
+                g_Sink = static_cast<int>(i);
+            }
+            traced += std::chrono::duration<double>(Clock::now() - b0).count();
+            while (ring.Pending() != 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        tracer.Stop();
+        std::printf("%lld scopes | %.1f ns per TRACE_SCOPE | %llu dropped\n",
+                    count, (traced - empty) * 1e9 / count, static_cast<unsigned long long>(tracer.Dropped()));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? std::atoll(argv[2]) : 1000000, argc > 3 ? argv[3] : "bench_trace.json");
+        return 0;
+    }
+
+    const char* path = argc > 1 ? argv[1] : "trace.json";
+    if (!Trace::Tracer::Instance().Start(path)) {
+        std::fprintf(stderr, "can't open %s\n", path);
+        return 1;
+    }
+    std::thread worker([]() {
+        TRACE_SCOPE("worker \"f\" x100");     // quotes end up escaped in the JSON
+        for (int i = 0; i < 100; ++i) {
+            f();
+        }
+    });
+    for (int i = 0; i < 100; ++i) {
+        f();
+    }
+    worker.join();
+    Trace::Tracer::Instance().Stop();
+    std::printf("wrote %s\n", path);
+    return 0;
+}
@@ -0,0 +1,357 @@
+/**
+ *          Tokenizer
+ * --------------------------------------------------
+ * 1_5_namespace.cpp only declares
+ *      namespace MyLib {
+ *          namespace Parser {
+ *              void Tokenizer() {}
+ *          }
+ *      }
+ * Here it is a real tokenizer for config and log text:
+ *      input is a std::string_view, every token is a std::string_view into the input
+ *      -> no std::string per token, no allocation at all
+ *
+ * Tokens:
+ *      spaces (' ' '\t' '\r' '\n') separate tokens and are dropped
+ *      delimiters (= , ; : [ ] { } ( ) " ' #) are one char tokens
+ *      everything else is a word
+ *
+ * Byte classes are looked up 16 at a time (SSSE3 pshufb nibble lookup):
+ *      class bits = low_table[c & 0xF] & high_table[c >> 4]
+ *      both tables are built from the class table at startup, so changing the delimiter set
+ *      is one line
+ *      the SSSE3 code is compiled with a target attribute (no -m flags needed) and used only
+ *      if CPUID has it; other compilers get it with -mssse3 / -march=native, else scalar only
+ *
+ * Modern C++:
+ *  C++17~ -> string_view was added, a pointer + length into someone else's string
+ *
+ * Usage:
+ *      1_5_2_tokenizer                     // small example
+ *      1_5_2_tokenizer --check [N]         // SIMD vs scalar on N random lines (says if SIMD is off)
+ *      1_5_2_tokenizer --bench [MB]        // std::string per token vs string_view, GB/s
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MYLIB_TOKENIZER_SIMD 1
+#include <immintrin.h>
+#define MYLIB_SSSE3 __attribute__((target("ssse3")))
+#elif defined(__SSSE3__)
+#define MYLIB_TOKENIZER_SIMD 1
+#include <immintrin.h>
+#define MYLIB_SSSE3
+#endif
+
+namespace MyLib {
+    namespace Parser {
+        enum ByteClass : uint8_t {Word = 0, Space = 1, Delimiter = 2};
+
+        // the SSSE3 path is compiled in and this CPU runs it
+        inline bool HasSimd() {
+#if defined(MYLIB_TOKENIZER_SIMD) && !defined(__SSSE3__)
+            static const bool s_Has = []() {
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("ssse3") != 0;
+            }();
+            return s_Has;
+#elif defined(MYLIB_TOKENIZER_SIMD)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        // class per byte + the nibble tables the SIMD lookup uses
+        class ByteClassTable {
+            uint8_t m_Class[256];
+            alignas(16) uint8_t m_Low[2][16];   // [space, delimiter][low nibble] -> high nibble buckets
+            alignas(16) uint8_t m_High[2][16];  // [space, delimiter][high nibble] -> its bucket bit
+        public:
+            ByteClassTable(const char* spaces, const char* delimiters) {
+                std::memset(m_Class, Word, sizeof(m_Class));
+                std::memset(m_Low, 0, sizeof(m_Low));
+                std::memset(m_High, 0, sizeof(m_High));
+                Add(spaces, Space);
+                Add(delimiters, Delimiter);
+            }
+
+            ByteClass operator [](char c) const { return static_cast<ByteClass>(m_Class[static_cast<uint8_t>(c)]); }
+
+#if defined(MYLIB_TOKENIZER_SIMD)
+            // bit i of space/delimiter == class of p[i]
+            MYLIB_SSSE3
+            void Classify16(const char* p, uint32_t& space, uint32_t& delimiter) const {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                __m128i low = _mm_and_si128(v, _mm_set1_epi8(0x0F));
+                __m128i high = _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+                space = Lookup(0, low, high);
+                delimiter = Lookup(1, low, high);
+            }
+
+        private:
+            MYLIB_SSSE3
+            uint32_t Lookup(int kind, __m128i low, __m128i high) const {
+                __m128i l = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(m_Low[kind])), low);
+                __m128i h = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(m_High[kind])), high);
+                __m128i hit = _mm_cmpeq_epi8(_mm_and_si128(l, h), _mm_setzero_si128());
+                return static_cast<uint32_t>(~_mm_movemask_epi8(hit)) & 0xFFFF;
+            }
+#endif
+
+        private:
+            // a set may use at most 8 different high nibbles (one bit each), plenty for ASCII punctuation
+            void Add(const char* chars, ByteClass byteClass) {
+                int kind = byteClass == Space ? 0 : 1;
+                for (const char* c = chars; *c != '\0'; ++c) {
+                    uint8_t u = static_cast<uint8_t>(*c);
+                    m_Class[u] = byteClass;
+                    uint8_t hi = u >> 4;
+                    if (m_High[kind][hi] == 0) {
+                        uint8_t used = 0;
+                        for (uint8_t bits : m_High[kind]) {
+                            used |= bits;
+                        }
+                        if (used == 0xFF) {
+                            std::abort();       // more than 8 high nibbles in one class
+                        }
+                        uint8_t bit = 1;
+                        while (used & bit) {
+                            bit <<= 1;
+                        }
+                        m_High[kind][hi] = bit;
+                    }
+                    m_Low[kind][u & 0xF] |= m_High[kind][hi];
+                }
+            }
+        };
+
+        inline const ByteClassTable& DefaultClasses() {
+            static const ByteClassTable table(" \t\r\n", "=,;:[]{}()\"'#");
+            return table;
+        }
+
+        class Tokenizer {
+            std::string_view m_Input;
+            size_t m_Pos = 0;
+            const ByteClassTable& m_Classes;
+            bool m_Simd;
+        public:
+            explicit Tokenizer(std::string_view input, bool simd = true,
+                               const ByteClassTable& classes = DefaultClasses()) :
+                m_Input(input),
+                m_Classes(classes),
+                m_Simd(simd && HasSimd()) {}
+
+            // false at the end of input
+            bool Next(std::string_view& token) {
+#if defined(MYLIB_TOKENIZER_SIMD)
+                if (m_Simd) {
+                    return NextSimd(token);
+                }
+#endif
+                return NextScalar(token);
+            }
+
+            // all tokens at once, out is reused so it stops allocating after the first call
+            static void Tokenize(std::string_view input, std::vector<std::string_view>& out, bool simd = true) {
+                out.clear();
+                Tokenizer tokenizer(input, simd);
+                std::string_view token;
+                while (tokenizer.Next(token)) {
+                    out.push_back(token);
+                }
+            }
+
+        private:
+            bool NextScalar(std::string_view& token) {
+                size_t size = m_Input.size();
+                while (m_Pos < size && m_Classes[m_Input[m_Pos]] == Space) {
+                    ++m_Pos;
+                }
+                if (m_Pos == size) {
+                    return false;
+                }
+                size_t start = m_Pos++;
+                if (m_Classes[m_Input[start]] == Word) {
+                    while (m_Pos < size && m_Classes[m_Input[m_Pos]] == Word) {
+                        ++m_Pos;
+                    }
+                }
+                token = m_Input.substr(start, m_Pos - start);
+                return true;
+            }
+
+#if defined(MYLIB_TOKENIZER_SIMD)
+            MYLIB_SSSE3
+            bool NextSimd(std::string_view& token) {
+                const char* data = m_Input.data();
+                size_t size = m_Input.size();
+                uint32_t space, delimiter;
+
+                // skip spaces 16 at a time
+                while (m_Pos + 16 <= size) {
+                    m_Classes.Classify16(data + m_Pos, space, delimiter);
+                    if (space != 0xFFFF) {
+                        m_Pos += static_cast<size_t>(__builtin_ctz(~space));
+                        break;
+                    }
+                    m_Pos += 16;
+                }
+                if (m_Pos + 16 > size) {
+                    return NextScalar(token);
+                }
+                size_t start = m_Pos;
+                if (m_Classes[data[start]] != Word) {
+                    token = m_Input.substr(start, 1);
+                    ++m_Pos;
+                    return true;
+                }
+                // word: runs until the next space or delimiter
+                ++m_Pos;
+                while (m_Pos + 16 <= size) {
+                    m_Classes.Classify16(data + m_Pos, space, delimiter);
+                    uint32_t stop = space | delimiter;
+                    if (stop != 0) {
+                        m_Pos += static_cast<size_t>(__builtin_ctz(stop));
+                        token = m_Input.substr(start, m_Pos - start);
+                        return true;
+                    }
+                    m_Pos += 16;
+                }
+                while (m_Pos < size && m_Classes[data[m_Pos]] == Word) {
+                    ++m_Pos;
+                }
+                token = m_Input.substr(start, m_Pos - start);
+                return true;
+            }
+#endif
+        };
+    }
+}
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    // the allocation-per-token way: a new std::string for every token
+    void TokenizeToStrings(const std::string& input, std::vector<std::string>& out) {
+        out.clear();
+        const MyLib::Parser::ByteClassTable& classes = MyLib::Parser::DefaultClasses();
+        std::string current;
+        for (char c : input) {
+            MyLib::Parser::ByteClass byteClass = classes[c];
+            if (byteClass == MyLib::Parser::Word) {
+                current += c;
+                continue;
+            }
+            if (!current.empty()) {
+                out.push_back(current);
+                current.clear();
+            }
+            if (byteClass == MyLib::Parser::Delimiter) {
+                out.push_back(std::string(1, c));
+            }
+        }
+        if (!current.empty()) {
+            out.push_back(current);
+        }
+    }
+
+    std::string MakeText(size_t bytes) {
+        const char* lines[] = {
+            "server.port = 8080\n",
+            "[section.database]\n",
+            "hosts = [\"db1\", \"db2\", \"db3\"]  # replicas\n",
+            "2024-05-01T12:00:00Z INFO request_id=af3e91 path=/api/v1/users status=200 latency_ms=12\n",
+            "    timeout: 30s; retries: 5; backoff: {min: 100ms, max: 10s}\n",
+            "2024-05-01T12:00:01Z WARN slow query (table=orders, rows=1234567, elapsed=1532ms)\n",
+        };
+        std::string text;
+        unsigned int seed = 1;
+        while (text.size() < bytes) {
+            seed = seed * 1103515245u + 12345u;
+            text += lines[(seed >> 16) % 6];
+        }
+        return text;
+    }
+
+    bool Check(int count) {
+        const char alphabet[] = "abcXYZ019 \t\r\n=,;:[]{}()\"'#._-/\x80\xff";
+        unsigned int seed = 7;
+        std::string text;
+        for (int i = 0; i < count; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            size_t length = (seed >> 16) % 80;
+            for (size_t j = 0; j < length; ++j) {
+                seed = seed * 1103515245u + 12345u;
+                text += alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+            }
+            if ((seed >> 8) % 4 == 0) {
+                text += std::string((seed >> 4) % 40, 'w');   // long words cross 16 byte windows
+            }
+            text += '\n';
+        }
+        std::vector<std::string_view> scalar, simd;
+        MyLib::Parser::Tokenizer::Tokenize(text, scalar, false);
+        MyLib::Parser::Tokenizer::Tokenize(text, simd, true);
+        bool same = scalar == simd;
+        std::cout << text.size() << " bytes, " << scalar.size() << " tokens, "
+                  << (!same ? "MISMATCH" : MyLib::Parser::HasSimd() ? "simd == scalar" : "ok (no SSSE3: scalar only, simd not checked)")
+                  << std::endl;
+        return same;
+    }
+
+    void Bench(size_t megabytes) {
+        std::string text = MakeText(megabytes << 20);
+        double gb = text.size() / (1024.0 * 1024.0 * 1024.0);
+        double sec[3];
+        size_t tokens[3];
+
+        std::vector<std::string> strings;
+        Clock::time_point t = Clock::now();
+        TokenizeToStrings(text, strings);
+        sec[0] = std::chrono::duration<double>(Clock::now() - t).count();
+        tokens[0] = strings.size();
+        std::vector<std::string>().swap(strings);
+
+        std::vector<std::string_view> views;
+        views.reserve(tokens[0]);
+        for (int simd = 0; simd < 2; ++simd) {
+            t = Clock::now();
+            MyLib::Parser::Tokenizer::Tokenize(text, views, simd == 1);
+            sec[1 + simd] = std::chrono::duration<double>(Clock::now() - t).count();
+            tokens[1 + simd] = views.size();
+        }
+        std::printf("%5zu MB, %zu tokens | std::string %6.2f GB/s | string_view scalar %6.2f GB/s | string_view simd %6.2f GB/s%s %s\n",
+                    megabytes, tokens[0], gb / sec[0], gb / sec[1], gb / sec[2],
+                    MyLib::Parser::HasSimd() ? "" : " (no SSSE3, scalar)",
+                    tokens[0] == tokens[1] && tokens[1] == tokens[2] ? "" : "MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+        return Check(argc > 2 ? std::atoi(argv[2]) : 100000) ? 0 : 1;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 256);
+        return 0;
+    }
+
+    MyLib::Parser::Tokenizer tokenizer("hosts = [\"db1\", \"db2\"]  # replicas");
+    std::string_view token;
+    while (tokenizer.Next(token)) {     // hosts | = | [ | " | db1 | " | , | ...
+        std::cout << token << " | ";
+    }
+    std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,451 @@
+/**
+ *          MyLib::File
+ * --------------------------------------------------
+ * 1_5_namespace.cpp leaves them empty:
+ *      namespace MyLib {
+ *          namespace File {
+ *              void Load() {};
+ *              void Save() {};
+ *          }
+ *      }
+ *
+ * Load(path) -> View
+ *      read-only mmap of the whole file. The page cache IS the buffer,
+ *      nothing is copied from the kernel into a std::string
+ * Chunks(path, size)
+ *      for files bigger than RAM (or address space): maps one window at a time,
+ *      unmaps it when the loop moves on
+ * Writer / Save(path, data)
+ *      writes go to a unique "path.XXXXXX" (mkstemp) and rename() over path at the end, so readers see the
+ *      old file or the new one, never half of it (no fsync: atomic, not durable)
+ *      small writes are batched in a page aligned buffer, big ones are not copied at all -
+ *      they go to writev() next to the buffer
+ *
+ * Usage:
+ *      1_5_3_file                          // small example
+ *      1_5_3_file --bench [MB [path]]      // Writer/Load/Chunks vs fstream in GB/s
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace MyLib {
+    namespace File {
+        // read-only view of a whole file, empty if it couldn't be opened
+        class View {
+            const char* m_Data = nullptr;
+            size_t m_Size = 0;
+#if defined(_WIN32)
+            std::vector<char> m_Buffer;         // no mmap here, plain read
+#endif
+        public:
+            View() = default;
+            explicit View(const char* path) { Open(path); }
+            View(View&& other) noexcept { Swap(other); }
+            View& operator =(View&& other) noexcept {
+                View(std::move(other)).Swap(*this);
+                return *this;
+            }
+            View(const View&) = delete;
+            View& operator =(const View&) = delete;
+            ~View() { Close(); }
+
+            bool IsOpen() const { return m_Data != nullptr; }
+            const char* data() const { return m_Data; }
+            size_t size() const { return m_Size; }
+            std::string_view Text() const { return std::string_view(m_Data, m_Size); }
+
+        private:
+            void Swap(View& other) {
+                std::swap(m_Data, other.m_Data);
+                std::swap(m_Size, other.m_Size);
+#if defined(_WIN32)
+                m_Buffer.swap(other.m_Buffer);
+#endif
+            }
+
+#if defined(_WIN32)
+            void Open(const char* path) {
+                std::FILE* file = std::fopen(path, "rb");
+                if (file == nullptr) {
+                    return;
+                }
+                std::fseek(file, 0, SEEK_END);
+                m_Buffer.resize(static_cast<size_t>(std::ftell(file)) + 1);
+                std::fseek(file, 0, SEEK_SET);
+                m_Size = std::fread(m_Buffer.data(), 1, m_Buffer.size() - 1, file);
+                std::fclose(file);
+                m_Data = m_Buffer.data();
+            }
+            void Close() {}
+#else
+            void Open(const char* path) {
+                int fd = ::open(path, O_RDONLY);
+                if (fd < 0) {
+                    return;
+                }
+                struct stat st;
+                if (::fstat(fd, &st) == 0) {
+                    m_Size = static_cast<size_t>(st.st_size);
+                    if (m_Size == 0) {
+                        m_Data = "";            // empty file is open, just has nothing in it
+                    } else {
+                        void* map = ::mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+                        if (map != MAP_FAILED) {
+                            ::madvise(map, m_Size, MADV_SEQUENTIAL);
+                            m_Data = static_cast<const char*>(map);
+                        } else {
+                            m_Size = 0;
+                        }
+                    }
+                }
+                ::close(fd);                    // the mapping keeps the file alive
+            }
+            void Close() {
+                if (m_Data != nullptr && m_Size != 0) {
+                    ::munmap(const_cast<char*>(m_Data), m_Size);
+                }
+                m_Data = nullptr;
+                m_Size = 0;
+            }
+#endif
+        };
+
+        inline View Load(const char* path) { return View(path); }
+
+#if !defined(_WIN32)
+        // for (std::string_view chunk : Chunks(path, 64 << 20)) { ... }
+        //      only one window is mapped at a time, chunks are cut at byte offsets (not lines)
+        class Chunks {
+            int m_Fd = -1;
+            size_t m_FileSize = 0;
+            size_t m_ChunkSize;
+        public:
+            class Iterator {
+                const Chunks* m_Owner = nullptr;
+                size_t m_Offset = 0;
+                void* m_Map = nullptr;
+                size_t m_Length = 0;
+            public:
+                typedef std::input_iterator_tag iterator_category;
+                typedef std::string_view value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const std::string_view* pointer;
+                typedef std::string_view reference;
+
+                Iterator() = default;
+                Iterator(const Chunks* owner, size_t offset) : m_Owner(owner), m_Offset(offset) { Map(); }
+                Iterator(const Iterator&) = delete;
+                Iterator& operator =(const Iterator&) = delete;
+                ~Iterator() { Unmap(); }
+
+                std::string_view operator *() const { return std::string_view(static_cast<const char*>(m_Map), m_Length); }
+                Iterator& operator ++() {
+                    Unmap();
+                    m_Offset += m_Length;
+                    Map();
+                    return *this;
+                }
+                bool operator !=(const Iterator& other) const { return m_Offset != other.m_Offset; }
+
+            private:
+                void Map() {
+                    if (m_Owner == nullptr || m_Offset >= m_Owner->m_FileSize) {
+                        m_Offset = m_Owner != nullptr ? m_Owner->m_FileSize : 0;
+                        return;
+                    }
+                    m_Length = std::min(m_Owner->m_ChunkSize, m_Owner->m_FileSize - m_Offset);
+                    m_Map = ::mmap(nullptr, m_Length, PROT_READ, MAP_PRIVATE, m_Owner->m_Fd, static_cast<off_t>(m_Offset));
+                    if (m_Map == MAP_FAILED) {
+                        m_Map = nullptr;
+                        m_Length = 0;
+                        m_Offset = m_Owner->m_FileSize;     // stop
+                        return;
+                    }
+                    ::madvise(m_Map, m_Length, MADV_SEQUENTIAL);
+                }
+                void Unmap() {
+                    if (m_Map != nullptr) {
+                        ::munmap(m_Map, m_Length);
+                        m_Map = nullptr;
+                    }
+                }
+            };
+
+            // chunkSize is rounded up to whole pages (mmap offsets have to be page aligned)
+            Chunks(const char* path, size_t chunkSize) {
+                size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+                m_ChunkSize = std::max(page, (chunkSize + page - 1) / page * page);
+                m_Fd = ::open(path, O_RDONLY);
+                struct stat st;
+                if (m_Fd >= 0 && ::fstat(m_Fd, &st) == 0) {
+                    m_FileSize = static_cast<size_t>(st.st_size);
+                }
+            }
+            Chunks(const Chunks&) = delete;
+            Chunks& operator =(const Chunks&) = delete;
+            ~Chunks() {
+                if (m_Fd >= 0) {
+                    ::close(m_Fd);
+                }
+            }
+
+            bool IsOpen() const { return m_Fd >= 0; }
+            Iterator begin() const { return Iterator(this, 0); }
+            Iterator end() const { return Iterator(this, m_FileSize); }
+        };
+#endif
+
+        // Writes to a new temp file next to path, Commit() renames it over path. Dropping a Writer
+        //      without Commit() unlinks the temp file and leaves path untouched.
+        //      Two Writers of the same path never share a temp file, the last Commit() wins
+        class Writer {
+            static const size_t s_BufferSize = 1 << 20;     // 1MB, page aligned
+            static const size_t s_Alignment = 4096;
+
+            std::string m_Path;
+            std::string m_TempPath;
+            char* m_Buffer = nullptr;
+            size_t m_Used = 0;
+            bool m_Ok = false;
+#if defined(_WIN32)
+            std::FILE* m_File = nullptr;
+#else
+            int m_Fd = -1;
+#endif
+        public:
+            explicit Writer(const char* path) : m_Path(path) {
+                m_Buffer = static_cast<char*>(::operator new(s_BufferSize, std::align_val_t(s_Alignment)));
+#if defined(_WIN32)
+                m_TempPath = m_Path + ".tmp";
+                m_File = std::fopen(m_TempPath.c_str(), "wb");
+                m_Ok = m_File != nullptr;
+#else
+                m_TempPath = m_Path + ".XXXXXX";     // same directory, so rename() stays on one filesystem
+                m_Fd = ::mkstemp(&m_TempPath[0]);
+                m_Ok = m_Fd >= 0 && ::fchmod(m_Fd, 0644) == 0;      // mkstemp creates it 0600
+#endif
+            }
+            Writer(const Writer&) = delete;
+            Writer& operator =(const Writer&) = delete;
+            ~Writer() {
+                if (IsOpenFile()) {
+                    CloseFile();
+                    std::remove(m_TempPath.c_str());    // not committed
+                }
+                ::operator delete(m_Buffer, std::align_val_t(s_Alignment));
+            }
+
+            bool Ok() const { return m_Ok; }
+
+            void Write(const char* data, size_t size) {
+                if (size <= s_BufferSize - m_Used) {
+                    std::memcpy(m_Buffer + m_Used, data, size);
+                    m_Used += size;
+                    if (m_Used == s_BufferSize) {
+                        WriteAll(nullptr, 0);
+                    }
+                } else if (size < s_BufferSize) {
+                    size_t part = s_BufferSize - m_Used;      // top the buffer up, flush, keep the rest
+                    std::memcpy(m_Buffer + m_Used, data, part);
+                    m_Used = s_BufferSize;
+                    WriteAll(nullptr, 0);
+                    std::memcpy(m_Buffer, data + part, size - part);
+                    m_Used = size - part;
+                } else {
+                    WriteAll(data, size);               // big: buffer + caller's bytes in one writev, no copy
+                }
+            }
+            void Write(std::string_view text) { Write(text.data(), text.size()); }
+
+            // flush + rename over the target. false if anything failed on the way
+            bool Commit() {
+                if (!IsOpenFile()) {
+                    return false;
+                }
+                WriteAll(nullptr, 0);
+                m_Ok = CloseFile() && m_Ok;
+                if (!m_Ok) {
+                    std::remove(m_TempPath.c_str());
+                    return false;
+                }
+#if defined(_WIN32)
+                std::remove(m_Path.c_str());            // (rename doesn't replace on Windows)
+#endif
+                m_Ok = std::rename(m_TempPath.c_str(), m_Path.c_str()) == 0;
+                if (!m_Ok) {
+                    std::remove(m_TempPath.c_str());
+                }
+                return m_Ok;
+            }
+
+        private:
+#if defined(_WIN32)
+            bool IsOpenFile() const { return m_File != nullptr; }
+            bool CloseFile() {
+                bool ok = std::fclose(m_File) == 0;
+                m_File = nullptr;
+                return ok;
+            }
+            void WriteAll(const char* extra, size_t extraSize) {
+                if (m_Ok && m_Used != 0) {
+                    m_Ok = std::fwrite(m_Buffer, 1, m_Used, m_File) == m_Used;
+                }
+                if (m_Ok && extraSize != 0) {
+                    m_Ok = std::fwrite(extra, 1, extraSize, m_File) == extraSize;
+                }
+                m_Used = 0;
+            }
+#else
+            bool IsOpenFile() const { return m_Fd >= 0; }
+            bool CloseFile() {
+                bool ok = ::close(m_Fd) == 0;
+                m_Fd = -1;
+                return ok;
+            }
+            // the buffer and (optionally) one caller span in a single writev, retried on short writes
+            void WriteAll(const char* extra, size_t extraSize) {
+                struct iovec iov[2] = {{m_Buffer, m_Used}, {const_cast<char*>(extra), extraSize}};
+                int first = m_Used != 0 ? 0 : 1;
+                int last = extraSize != 0 ? 2 : 1;
+                while (m_Ok && first < last) {
+                    ssize_t n = ::writev(m_Fd, iov + first, last - first);
+                    if (n < 0) {
+                        m_Ok = errno == EINTR;
+                        continue;
+                    }
+                    size_t done = static_cast<size_t>(n);
+                    while (first < last && done >= iov[first].iov_len) {
+                        done -= iov[first].iov_len;
+                        ++first;
+                    }
+                    if (first < last) {
+                        iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + done;
+                        iov[first].iov_len -= done;
+                    }
+                }
+                m_Used = 0;
+            }
+#endif
+        };
+
+        // whole file at once through the Writer
+        inline bool Save(const char* path, std::string_view data) {
+            Writer writer(path);
+            writer.Write(data);
+            return writer.Commit();
+        }
+    }
+}
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double Seconds(Clock::time_point from) {
+        return std::chrono::duration<double>(Clock::now() - from).count();
+    }
+
+    uint64_t Checksum(const char* data, size_t size) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < size; i += 64) {     // one touch per cache line, we measure I/O not math
+            sum += static_cast<unsigned char>(data[i]);
+        }
+        return sum;
+    }
+
+    void Bench(size_t megabytes, const std::string& path) {
+        std::string record(4096 - 1, 'x');
+        record += '\n';
+        size_t records = (megabytes << 20) / record.size();
+        double gb = static_cast<double>(records * record.size()) / (1024.0 * 1024.0 * 1024.0);
+
+        Clock::time_point t = Clock::now();
+        {
+            std::ofstream out(path, std::ios::binary);
+            for (size_t i = 0; i < records; ++i) {
+                out.write(record.data(), static_cast<std::streamsize>(record.size()));
+            }
+        }
+        double ofstreamSec = Seconds(t);
+
+        t = Clock::now();
+        MyLib::File::Writer writer(path.c_str());
+        for (size_t i = 0; i < records; ++i) {
+            writer.Write(record);
+        }
+        bool ok = writer.Commit();
+        double writerSec = Seconds(t);
+
+        t = Clock::now();
+        std::string copy;
+        {
+            std::ifstream in(path, std::ios::binary);
+            copy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        uint64_t sum1 = Checksum(copy.data(), copy.size());
+        double ifstreamSec = Seconds(t);
+        std::string().swap(copy);
+
+        t = Clock::now();
+        MyLib::File::View view = MyLib::File::Load(path.c_str());
+        uint64_t sum2 = Checksum(view.data(), view.size());
+        double loadSec = Seconds(t);
+
+        uint64_t sum3 = sum2;
+#if !defined(_WIN32)
+        t = Clock::now();
+        sum3 = 0;
+        for (std::string_view chunk : MyLib::File::Chunks(path.c_str(), 64 << 20)) {
+            sum3 += Checksum(chunk.data(), chunk.size());   // (64MB chunks are 64 byte aligned too)
+        }
+#endif
+        double chunksSec = Seconds(t);
+        std::remove(path.c_str());
+
+        std::printf("%5zu MB | write: ofstream %6.2f GB/s  Writer %6.2f GB/s | read: ifstream %6.2f GB/s  Load %6.2f GB/s  Chunks %6.2f GB/s %s\n",
+                    megabytes, gb / ofstreamSec, gb / writerSec, gb / ifstreamSec, gb / loadSec, gb / chunksSec,
+                    ok && sum1 == sum2 && sum2 == sum3 ? "" : "MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 1024, argc > 3 ? argv[3] : "1_5_3_file.bench");
+        return 0;
+    }
+
+    const char* path = "1_5_3_file.txt";
+    if (!MyLib::File::Save(path, "server.port = 8080\nserver.host = localhost\n")) {
+        std::cerr << "can't save " << path << std::endl;
+        return 1;
+    }
+    {
+        MyLib::File::Writer abandoned(path);
+        abandoned.Write("half a config");
+    }                                   // no Commit(): its temp file is gone, path is untouched
+    MyLib::File::View view = MyLib::File::Load(path);
+    std::cout << view.Text();           // the same two lines, straight from the page cache
+    std::remove(path);
+    return 0;
+}
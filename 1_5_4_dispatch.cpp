@@ -0,0 +1,281 @@
+/**
+ *          Runtime Dispatch
+ * --------------------------------------------------
+ * 1_5_namespace.cpp picks the platform at compile time:
+ *      namespace MyLib {
+ *          namespace Windows { int f() {return 1;} }
+ *          namespace Linux   { int f() {return 2;} }
+ *      }
+ *      using namespace MyLib::Windows;
+ * That works for the OS, but not for the CPU: one binary goes to old and new nodes alike.
+ *
+ * Here every hot kernel is compiled 4 times (Scalar, Sse42, Avx2, Avx512 namespaces,
+ *      GCC/Clang target attributes, so the file itself builds without -march flags).
+ * At startup CPUID picks the widest one the CPU has and fills a table of function pointers.
+ *      a call is one indirect call through that table - no per-call if/switch
+ *
+ * Versioning with inline namespace (C++11):
+ *      MyLib::Linux::Sum(...)      -> v2 (inline, the current API: size_t counts)
+ *      MyLib::Linux::v1::Sum(...)  -> the old int count API, still there for old callers
+ *
+ * Usage:
+ *      1_5_4_dispatch                  // which kernels were picked
+ *      1_5_4_dispatch --bench [N]      // every level the CPU supports, checked against scalar
+ *      MYLIB_ISA=sse42 1_5_4_dispatch  // cap the level (scalar, sse42, avx2, avx512)
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MYLIB_X86_DISPATCH 1
+#include <immintrin.h>
+#define MYLIB_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace MyLib {
+    namespace Linux {
+        inline namespace v2 {
+            enum class Isa {Scalar, Sse42, Avx2, Avx512};
+
+            // by Isa, also the spelling MYLIB_ISA takes
+            inline constexpr const char* s_IsaNames[] = {"scalar", "sse42", "avx2", "avx512"};
+
+            inline const char* IsaName(Isa isa) { return s_IsaNames[static_cast<int>(isa)]; }
+
+            namespace Scalar {
+                inline int64_t Sum(const int32_t* data, size_t count) {
+                    int64_t sum = 0;
+                    for (size_t i = 0; i < count; ++i) {
+                        sum += data[i];
+                    }
+                    return sum;
+                }
+
+                inline size_t CountByte(const char* data, size_t size, char c) {
+                    size_t count = 0;
+                    for (size_t i = 0; i < size; ++i) {
+                        count += data[i] == c;
+                    }
+                    return count;
+                }
+            }
+
+#if defined(MYLIB_X86_DISPATCH)
+            namespace Sse42 {
+                MYLIB_TARGET("sse4.2")
+                inline int64_t Sum(const int32_t* data, size_t count) {
+                    __m128i sum = _mm_setzero_si128();
+                    size_t i = 0;
+                    for (; i + 4 <= count; i += 4) {
+                        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                        sum = _mm_add_epi64(sum, _mm_cvtepi32_epi64(v));
+                        sum = _mm_add_epi64(sum, _mm_cvtepi32_epi64(_mm_srli_si128(v, 8)));
+                    }
+                    alignas(16) int64_t lanes[2];        // (_mm_extract_epi64 only exists on x86-64)
+                    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), sum);
+                    return lanes[0] + lanes[1] + Scalar::Sum(data + i, count - i);
+                }
+
+                MYLIB_TARGET("sse4.2,popcnt")
+                inline size_t CountByte(const char* data, size_t size, char c) {
+                    __m128i needle = _mm_set1_epi8(c);
+                    size_t count = 0;
+                    size_t i = 0;
+                    for (; i + 16 <= size; i += 16) {
+                        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                        count += static_cast<size_t>(_mm_popcnt_u32(static_cast<unsigned>(
+                            _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)))));
+                    }
+                    return count + Scalar::CountByte(data + i, size - i, c);
+                }
+            }
+
+            namespace Avx2 {
+                MYLIB_TARGET("avx2")
+                inline int64_t Sum(const int32_t* data, size_t count) {
+                    __m256i sum = _mm256_setzero_si256();
+                    size_t i = 0;
+                    for (; i + 8 <= count; i += 8) {
+                        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 4));
+                        sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(lo));
+                        sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(hi));
+                    }
+                    alignas(32) int64_t lanes[4];
+                    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sum);
+                    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + Scalar::Sum(data + i, count - i);
+                }
+
+                MYLIB_TARGET("avx2,popcnt")
+                inline size_t CountByte(const char* data, size_t size, char c) {
+                    __m256i needle = _mm256_set1_epi8(c);
+                    size_t count = 0;
+                    size_t i = 0;
+                    for (; i + 32 <= size; i += 32) {
+                        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                        count += static_cast<size_t>(_mm_popcnt_u32(static_cast<unsigned>(
+                            _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)))));
+                    }
+                    return count + Scalar::CountByte(data + i, size - i, c);
+                }
+            }
+
+            namespace Avx512 {
+                MYLIB_TARGET("avx512f")
+                inline int64_t Sum(const int32_t* data, size_t count) {
+                    __m512i sum = _mm512_setzero_si512();
+                    size_t i = 0;
+                    for (; i + 16 <= count; i += 16) {
+                        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 8));
+                        sum = _mm512_add_epi64(sum, _mm512_maskz_cvtepi32_epi64(0xFF, lo));   // (maskz/store: gcc 12's headers warn on the plain forms)
+                        sum = _mm512_add_epi64(sum, _mm512_maskz_cvtepi32_epi64(0xFF, hi));
+                    }
+                    alignas(64) int64_t lanes[8];
+                    _mm512_store_si512(lanes, sum);
+                    int64_t result = 0;
+                    for (int64_t lane : lanes) {
+                        result += lane;
+                    }
+                    return result + Scalar::Sum(data + i, count - i);
+                }
+
+                MYLIB_TARGET("avx512f,avx512bw,popcnt")
+                inline size_t CountByte(const char* data, size_t size, char c) {
+                    __m512i needle = _mm512_set1_epi8(c);
+                    size_t count = 0;
+                    size_t i = 0;
+                    for (; i + 64 <= size; i += 64) {
+                        __m512i v = _mm512_loadu_si512(data + i);
+                        count += static_cast<size_t>(__builtin_popcountll(_mm512_cmpeq_epi8_mask(v, needle)));
+                    }
+                    return count + Scalar::CountByte(data + i, size - i, c);
+                }
+            }
+#endif
+
+            // one entry per kernel, filled once
+            struct Kernels {
+                Isa isa;
+                int64_t (*sum)(const int32_t*, size_t);
+                size_t (*countByte)(const char*, size_t, char);
+            };
+
+            inline Kernels KernelsFor(Isa isa) {
+                switch (isa) {
+#if defined(MYLIB_X86_DISPATCH)
+                case Isa::Avx512: return {isa, &Avx512::Sum, &Avx512::CountByte};
+                case Isa::Avx2: return {isa, &Avx2::Sum, &Avx2::CountByte};
+                case Isa::Sse42: return {isa, &Sse42::Sum, &Sse42::CountByte};
+#endif
+                default: return {Isa::Scalar, &Scalar::Sum, &Scalar::CountByte};
+                }
+            }
+
+            // widest level the CPU (and OS, for the AVX state) supports
+            inline Isa DetectIsa() {
+#if defined(MYLIB_X86_DISPATCH)
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+                    return Isa::Avx512;
+                }
+                if (__builtin_cpu_supports("avx2")) {
+                    return Isa::Avx2;
+                }
+                if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+                    return Isa::Sse42;
+                }
+#endif
+                return Isa::Scalar;
+            }
+
+            // MYLIB_ISA can lower the level, never raise it past what the CPU has
+            inline Isa SelectIsa() {
+                Isa isa = DetectIsa();
+                if (const char* cap = std::getenv("MYLIB_ISA")) {
+                    for (int i = 0; i <= static_cast<int>(isa); ++i) {
+                        if (std::strcmp(cap, s_IsaNames[i]) == 0) {
+                            return static_cast<Isa>(i);
+                        }
+                    }
+                }
+                return isa;
+            }
+
+            // picked during static initialization, before main
+            inline const Kernels g_Kernels = KernelsFor(SelectIsa());
+
+            inline int64_t Sum(const int32_t* data, size_t count) { return g_Kernels.sum(data, count); }
+            inline size_t CountByte(const char* data, size_t size, char c) { return g_Kernels.countByte(data, size, c); }
+        }
+
+        // the old API, kept so code written against v1 still compiles and links
+        namespace v1 {
+            inline long long Sum(const int* data, int count) {
+                return v2::Sum(reinterpret_cast<const int32_t*>(data), static_cast<size_t>(count));
+            }
+        }
+    }
+}
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    void Bench(size_t count) {
+        using namespace MyLib::Linux;
+        std::vector<int32_t> numbers(count);
+        std::vector<char> text(count * 4);
+        for (size_t i = 0; i < count; ++i) {
+            numbers[i] = static_cast<int32_t>(i * 2654435761u);
+        }
+        for (size_t i = 0; i < text.size(); ++i) {
+            text[i] = static_cast<char>("abc\n"[(i * 7) % 4]);
+        }
+        int64_t expectedSum = Scalar::Sum(numbers.data(), count);
+        size_t expectedCount = Scalar::CountByte(text.data(), text.size(), '\n');
+
+        for (int level = 0; level <= static_cast<int>(DetectIsa()); ++level) {
+            Kernels kernels = KernelsFor(static_cast<Isa>(level));
+            const int repeat = 20;
+            int64_t sum = 0;
+            size_t found = 0;
+
+            Clock::time_point t = Clock::now();
+            for (int r = 0; r < repeat; ++r) {
+                sum = kernels.sum(numbers.data(), count);
+            }
+            double sumSec = std::chrono::duration<double>(Clock::now() - t).count() / repeat;
+
+            t = Clock::now();
+            for (int r = 0; r < repeat; ++r) {
+                found = kernels.countByte(text.data(), text.size(), '\n');
+            }
+            double countSec = std::chrono::duration<double>(Clock::now() - t).count() / repeat;
+
+            std::printf("%-7s | Sum %6.2f GB/s | CountByte %6.2f GB/s %s\n", IsaName(kernels.isa),
+                        count * sizeof(int32_t) / sumSec / 1e9, text.size() / countSec / 1e9,
+                        sum == expectedSum && found == expectedCount ? "" : "MISMATCH");
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 16 << 20);
+        return 0;
+    }
+
+    int32_t numbers[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    const char text[] = "a\nb\nc\n";
+    std::printf("cpu: %s, using: %s\n", MyLib::Linux::IsaName(MyLib::Linux::DetectIsa()),
+                MyLib::Linux::IsaName(MyLib::Linux::g_Kernels.isa));
+    std::printf("Sum = %lld\n", static_cast<long long>(MyLib::Linux::Sum(numbers, 10)));       // v2, 55
+    std::printf("v1::Sum = %lld\n", MyLib::Linux::v1::Sum(numbers, 10));                        // 55
+    std::printf("CountByte = %zu\n", MyLib::Linux::CountByte(text, sizeof(text) - 1, '\n'));    // 3
+    return 0;
+}
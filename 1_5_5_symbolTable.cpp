@@ -0,0 +1,549 @@
+/**
+ *          Symbol Table
+ * --------------------------------------------------
+ * 1_5_namespace.cpp shows how C++ finds a name:
+ *      nested namespaces           MyLib::Parser::Tokenizer()
+ *      using directives            namespace MyModule { using namespace G; using namespace H; }
+ *                                  MyModule::f() -> G::f()
+ *      ambiguity                   using namespace MyModule1; using namespace MyModule2;
+ *                                  Test() -> MyModule1::Test or MyModule2::Test? (compile error)
+ *
+ * This is a resolver for that model, for millions of lookups:
+ *      Interner        every name is stored once, a name is a 32 bit id afterwards
+ *      FlatHashMap     open addressing, 16 control bytes (7 bits of the hash each) checked with
+ *                      one SSE2 compare per probe, so most misses never touch a key
+ *      using closure   the namespaces reachable through using directives, per namespace,
+ *                      computed once (level by level) and cached
+ *      result cache    (scope, name) -> found / not found / ambiguous, so after the first time a
+ *                      lookup - ambiguity included - is one hash probe per path component
+ *
+ * Lookup rules (simplified):
+ *      in a namespace N: N's own declarations, else the using closure of N level by level,
+ *                        two different entities on the same level = ambiguous
+ *      unqualified:      the same from the current scope outwards to the global namespace
+ *
+ * Usage:
+ *      1_5_5_symbolTable                   // the 1_5_namespace.cpp cases
+ *      1_5_5_symbolTable --bench [N]       // N namespaces, lookups/s cached vs uncached
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// open addressing hash map, Swiss table style. insert and find only (no erase)
+template <class K, class V, class Hash = std::hash<K>, class Eq = std::equal_to<K>>
+class FlatHashMap {
+    static constexpr int8_t s_Empty = -128;     // 0b10000000, full slots hold 0~127
+    static constexpr size_t s_Group = 16;
+
+    std::vector<int8_t> m_Control;
+    std::vector<std::pair<K, V>> m_Slots;
+    size_t m_Size = 0;
+    size_t m_GroupMask = 0;                 // groups - 1, groups is a power of 2
+    Hash m_Hash;
+    Eq m_Eq;
+
+public:
+    FlatHashMap() { Rehash(1); }
+
+    size_t size() const { return m_Size; }
+
+    void clear() {
+        std::vector<int8_t>().swap(m_Control);
+        std::vector<std::pair<K, V>>().swap(m_Slots);
+        m_Size = 0;
+        Rehash(1);
+    }
+
+    const V* Find(const K& key) const {
+        size_t h = Mix(m_Hash(key));
+        int8_t tag = static_cast<int8_t>(h >> 57);
+        for (size_t group = h & m_GroupMask, step = 1; ; group = (group + step++) & m_GroupMask) {
+            const int8_t* control = &m_Control[group * s_Group];
+            for (uint32_t match = Match(control, tag); match != 0; match &= match - 1) {
+                size_t slot = group * s_Group + static_cast<size_t>(CountTrailingZeros(match));
+                if (m_Eq(m_Slots[slot].first, key)) {
+                    return &m_Slots[slot].second;
+                }
+            }
+            if (Match(control, s_Empty) != 0) {
+                return nullptr;             // an empty slot ends the probe sequence
+            }
+        }
+    }
+
+    // returns the existing value if key is already there
+    V& Insert(const K& key, const V& value) {
+        if (V* found = const_cast<V*>(Find(key))) {
+            return *found;
+        }
+        if ((m_Size + 1) * 8 > m_Slots.size() * 7) {   // max load 7/8
+            Rehash((m_GroupMask + 1) * 2);
+        }
+        return Place(key, value);
+    }
+
+private:
+    static size_t Mix(size_t h) {
+        uint64_t x = static_cast<uint64_t>(h) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(x ^ (x >> 32));
+    }
+
+    static int CountTrailingZeros(uint32_t x) {
+#if defined(_MSC_VER)
+        unsigned long i;
+        _BitScanForward(&i, x);
+        return static_cast<int>(i);
+#else
+        return __builtin_ctz(x);
+#endif
+    }
+
+    // bit i set if control[i] == tag
+    static uint32_t Match(const int8_t* control, int8_t tag) {
+#if defined(__SSE2__) || defined(_M_X64)
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < s_Group; ++i) {
+            mask |= static_cast<uint32_t>(control[i] == tag) << i;
+        }
+        return mask;
+#endif
+    }
+
+    V& Place(const K& key, const V& value) {
+        size_t h = Mix(m_Hash(key));
+        for (size_t group = h & m_GroupMask, step = 1; ; group = (group + step++) & m_GroupMask) {
+            uint32_t empty = Match(&m_Control[group * s_Group], s_Empty);
+            if (empty != 0) {
+                size_t slot = group * s_Group + static_cast<size_t>(CountTrailingZeros(empty));
+                m_Control[slot] = static_cast<int8_t>(h >> 57);
+                m_Slots[slot] = std::make_pair(key, value);
+                ++m_Size;
+                return m_Slots[slot].second;
+            }
+        }
+    }
+
+    void Rehash(size_t groups) {
+        std::vector<int8_t> control(groups * s_Group, s_Empty);
+        std::vector<std::pair<K, V>> slots(groups * s_Group);
+        control.swap(m_Control);
+        slots.swap(m_Slots);
+        m_GroupMask = groups - 1;
+        m_Size = 0;
+        for (size_t i = 0; i < control.size(); ++i) {
+            if (control[i] != s_Empty) {
+                Place(slots[i].first, slots[i].second);
+            }
+        }
+    }
+};
+
+// every distinct string stored once, in big chunks that never move
+class Interner {
+    static constexpr size_t s_ChunkSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> m_Chunks;
+    size_t m_Used = s_ChunkSize;
+    std::vector<std::string_view> m_Names;
+    FlatHashMap<std::string_view, uint32_t> m_Ids;
+
+public:
+    static constexpr uint32_t s_None = 0xFFFFFFFF;
+
+    uint32_t Intern(std::string_view name) {
+        if (const uint32_t* id = m_Ids.Find(name)) {
+            return *id;
+        }
+        std::string_view stored = Store(name);
+        uint32_t id = static_cast<uint32_t>(m_Names.size());
+        m_Names.push_back(stored);
+        m_Ids.Insert(stored, id);
+        return id;
+    }
+
+    // s_None if the name was never interned (then nothing can be declared with it either)
+    uint32_t Find(std::string_view name) const {
+        const uint32_t* id = m_Ids.Find(name);
+        return id != nullptr ? *id : s_None;
+    }
+
+    std::string_view Name(uint32_t id) const { return m_Names[id]; }
+
+private:
+    std::string_view Store(std::string_view name) {
+        if (m_Chunks.empty() || name.size() > s_ChunkSize - m_Used) {
+            m_Chunks.emplace_back(new char[std::max(name.size(), s_ChunkSize)]);
+            m_Used = 0;
+        }
+        char* p = m_Chunks.back().get() + m_Used;
+        std::memcpy(p, name.data(), name.size());
+        m_Used += name.size();
+        return std::string_view(p, name.size());
+    }
+};
+
+class SymbolTable {
+public:
+    typedef uint32_t NamespaceId;
+    typedef uint32_t EntityId;
+    static constexpr NamespaceId s_Global = 0;
+
+    struct Result {
+        enum Kind {NotFound, Found, Ambiguous};
+        Kind kind = NotFound;
+        EntityId entity = 0;        // Found: the entity, Ambiguous: one of the candidates
+        EntityId other = 0;         // Ambiguous: another one
+    };
+
+private:
+    struct Entity {
+        uint32_t name;
+        NamespaceId owner;
+        NamespaceId namespaceId;    // != s_NotNamespace if this entity is a namespace
+    };
+    struct Namespace {
+        EntityId entity;
+        NamespaceId parent;
+        std::vector<NamespaceId> usings;
+    };
+    struct KeyHash {
+        size_t operator ()(uint64_t key) const { return static_cast<size_t>(key ^ (key >> 29)); }
+    };
+    static constexpr NamespaceId s_NotNamespace = 0xFFFFFFFF;
+    static constexpr uint64_t s_Unqualified = 1ull << 63;
+
+    Interner m_Names;
+    std::vector<Entity> m_Entities;
+    std::vector<Namespace> m_Namespaces;
+    FlatHashMap<uint64_t, EntityId, KeyHash> m_Declarations;        // (namespace, name) -> entity
+
+    struct CachedResult {
+        Result result;
+        uint32_t generation;        // m_Generations[symbol] when it was resolved
+    };
+
+    // caches: a using directive drops both, a declaration only outdates its own name
+    std::vector<std::vector<std::vector<NamespaceId>>> m_Closures;  // [namespace][level] -> namespaces
+    std::vector<bool> m_ClosureReady;
+    FlatHashMap<uint64_t, CachedResult, KeyHash> m_Results;
+    std::vector<uint32_t> m_Generations;                            // [symbol] -> declarations of it so far
+    bool m_UseCache = true;
+
+public:
+    SymbolTable() {
+        m_Entities.push_back({m_Names.Intern(""), s_Global, s_Global});
+        m_Namespaces.push_back({0, s_Global, {}});
+    }
+
+    void UseCache(bool use) { m_UseCache = use; }
+
+    // namespace name { } - opening it again returns the same namespace
+    NamespaceId AddNamespace(NamespaceId parent, std::string_view name) {
+        uint32_t symbol = m_Names.Intern(name);
+        if (const EntityId* existing = m_Declarations.Find(Key(parent, symbol))) {
+            if (m_Entities[*existing].namespaceId != s_NotNamespace) {
+                return m_Entities[*existing].namespaceId;
+            }
+        }
+        NamespaceId id = static_cast<NamespaceId>(m_Namespaces.size());
+        EntityId entity = Declare(parent, symbol, id);
+        m_Namespaces.push_back({entity, parent, {}});
+        return id;
+    }
+
+    EntityId AddFunction(NamespaceId owner, std::string_view name) {
+        return Declare(owner, m_Names.Intern(name), s_NotNamespace);
+    }
+
+    // using namespace nominated; inside scope
+    void AddUsing(NamespaceId scope, NamespaceId nominated) {
+        m_Namespaces[scope].usings.push_back(nominated);
+        Invalidate();
+    }
+
+    // "f", "MyLib::Parser::Tokenizer", "::A::f" looked up from scope
+    Result Lookup(NamespaceId scope, std::string_view path) {
+        bool global = path.substr(0, 2) == "::";
+        if (global) {
+            path.remove_prefix(2);
+        }
+        Result result;
+        NamespaceId current = global ? s_Global : scope;
+        bool qualified = global;
+        while (true) {
+            size_t end = path.find("::");
+            uint32_t symbol = m_Names.Find(path.substr(0, end));
+            if (symbol == Interner::s_None) {
+                return Result();
+            }
+            result = qualified ? LookupIn(current, symbol) : LookupFrom(current, symbol);
+            if (end == std::string_view::npos || result.kind != Result::Found) {
+                return result;
+            }
+            current = m_Entities[result.entity].namespaceId;
+            if (current == s_NotNamespace) {
+                return Result();        // f::x - f isn't a namespace
+            }
+            path.remove_prefix(end + 2);
+            qualified = true;
+        }
+    }
+
+    std::string QualifiedName(EntityId entity) const {
+        std::string name(m_Names.Name(m_Entities[entity].name));
+        for (NamespaceId ns = m_Entities[entity].owner; ns != s_Global; ns = m_Namespaces[ns].parent) {
+            name = std::string(m_Names.Name(m_Entities[m_Namespaces[ns].entity].name)) + "::" + name;
+        }
+        return name;
+    }
+
+private:
+    static uint64_t Key(NamespaceId ns, uint32_t symbol) { return static_cast<uint64_t>(ns) << 32 | symbol; }
+
+    EntityId Declare(NamespaceId owner, uint32_t symbol, NamespaceId namespaceId) {
+        EntityId entity = static_cast<EntityId>(m_Entities.size());
+        m_Entities.push_back({symbol, owner, namespaceId});
+        m_Declarations.Insert(Key(owner, symbol), entity);
+        if (symbol >= m_Generations.size()) {
+            m_Generations.resize(symbol + 1, 0);
+        }
+        ++m_Generations[symbol];
+        return entity;
+    }
+
+    uint32_t Generation(uint32_t symbol) const { return symbol < m_Generations.size() ? m_Generations[symbol] : 0; }
+
+    const Result* FindCached(uint64_t key, uint32_t symbol) const {
+        const CachedResult* cached = m_Results.Find(key);
+        return cached != nullptr && cached->generation == Generation(symbol) ? &cached->result : nullptr;
+    }
+
+    Result Cache(uint64_t key, uint32_t symbol, const Result& result) {
+        CachedResult& entry = m_Results.Insert(key, {result, Generation(symbol)});
+        entry = {result, Generation(symbol)};      // Insert keeps an outdated entry
+        return result;
+    }
+
+    void Invalidate() {
+        m_ClosureReady.assign(m_Namespaces.size() + 1, false);
+        if (m_Results.size() != 0) {
+            m_Results.clear();
+        }
+    }
+
+    // qualified: ns::symbol
+    Result LookupIn(NamespaceId ns, uint32_t symbol) {
+        if (!m_UseCache) {
+            return Resolve(ns, symbol);
+        }
+        uint64_t key = Key(ns, symbol);
+        if (const Result* cached = FindCached(key, symbol)) {
+            return *cached;
+        }
+        return Cache(key, symbol, Resolve(ns, symbol));
+    }
+
+    // unqualified: scope, then every enclosing namespace
+    Result LookupFrom(NamespaceId scope, uint32_t symbol) {
+        uint64_t key = Key(scope, symbol) | s_Unqualified;
+        if (m_UseCache) {
+            if (const Result* cached = FindCached(key, symbol)) {
+                return *cached;
+            }
+        }
+        Result result;
+        for (NamespaceId ns = scope; ; ns = m_Namespaces[ns].parent) {
+            result = LookupIn(ns, symbol);
+            if (result.kind != Result::NotFound || ns == s_Global) {
+                break;
+            }
+        }
+        return m_UseCache ? Cache(key, symbol, result) : result;
+    }
+
+    // the uncached rule
+    Result Resolve(NamespaceId ns, uint32_t symbol) {
+        Result result;
+        if (const EntityId* own = m_Declarations.Find(Key(ns, symbol))) {
+            result.kind = Result::Found;
+            result.entity = *own;
+            return result;
+        }
+        for (const std::vector<NamespaceId>& level : Closure(ns)) {
+            for (NamespaceId nominated : level) {
+                const EntityId* found = m_Declarations.Find(Key(nominated, symbol));
+                if (found == nullptr || (result.kind != Result::NotFound && *found == result.entity)) {
+                    continue;
+                }
+                if (result.kind == Result::NotFound) {
+                    result.kind = Result::Found;
+                    result.entity = *found;
+                } else {
+                    result.kind = Result::Ambiguous;
+                    result.other = *found;
+                    return result;
+                }
+            }
+            if (result.kind != Result::NotFound) {
+                return result;          // found on this level, deeper levels are hidden
+            }
+        }
+        return result;
+    }
+
+    // namespaces reachable through using directives, by distance (each one only once)
+    const std::vector<std::vector<NamespaceId>>& Closure(NamespaceId ns) {
+        if (m_Closures.size() < m_Namespaces.size()) {
+            m_Closures.resize(m_Namespaces.size());
+        }
+        if (m_ClosureReady.size() < m_Namespaces.size()) {
+            m_ClosureReady.resize(m_Namespaces.size(), false);
+        }
+        std::vector<std::vector<NamespaceId>>& levels = m_Closures[ns];
+        if (m_ClosureReady[ns]) {
+            return levels;
+        }
+        levels.clear();
+        std::vector<bool> seen(m_Namespaces.size(), false);
+        seen[ns] = true;
+        std::vector<NamespaceId> frontier(1, ns);
+        while (!frontier.empty()) {
+            std::vector<NamespaceId> next;
+            for (NamespaceId from : frontier) {
+                for (NamespaceId to : m_Namespaces[from].usings) {
+                    if (!seen[to]) {
+                        seen[to] = true;
+                        next.push_back(to);
+                    }
+                }
+            }
+            if (!next.empty()) {
+                levels.push_back(next);
+            }
+            frontier.swap(next);
+        }
+        m_ClosureReady[ns] = true;
+        return levels;
+    }
+};
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    void Print(SymbolTable& table, SymbolTable::NamespaceId scope, const char* path) {
+        SymbolTable::Result r = table.Lookup(scope, path);
+        std::cout << path << " -> ";
+        if (r.kind == SymbolTable::Result::Found) {
+            std::cout << table.QualifiedName(r.entity) << "\n";
+        } else if (r.kind == SymbolTable::Result::Ambiguous) {
+            std::cout << "ambiguous (" << table.QualifiedName(r.entity) << ", "
+                      << table.QualifiedName(r.other) << ")\n";
+        } else {
+            std::cout << "not found\n";
+        }
+    }
+
+    void Bench(uint32_t namespaceCount) {
+        SymbolTable table;
+        std::vector<SymbolTable::NamespaceId> spaces(1, SymbolTable::s_Global);
+        std::vector<std::string> paths;
+        unsigned int seed = 42;
+        auto random = [&seed]() { seed = seed * 1103515245u + 12345u; return seed >> 8; };
+
+        for (uint32_t i = 1; i < namespaceCount; ++i) {
+            SymbolTable::NamespaceId parent = spaces[random() % spaces.size()];
+            spaces.push_back(table.AddNamespace(parent, "ns" + std::to_string(i)));
+            for (int f = 0; f < 8; ++f) {
+                table.AddFunction(spaces.back(), "func" + std::to_string(random() % 64));
+            }
+            if (random() % 4 == 0) {
+                table.AddUsing(spaces.back(), spaces[random() % spaces.size()]);
+            }
+        }
+        // lookups: "nsA::funcN" from random scopes
+        for (int i = 0; i < 100000; ++i) {
+            paths.push_back("ns" + std::to_string(1 + random() % (namespaceCount - 1)) + "::func" + std::to_string(random() % 64));
+        }
+
+        const size_t lookups = 2000000;
+        double sec[2];
+        size_t found[2] = {0, 0};
+        for (int cached = 0; cached < 2; ++cached) {
+            table.UseCache(cached == 1);
+            Clock::time_point t = Clock::now();
+            for (size_t i = 0; i < lookups; ++i) {
+                SymbolTable::NamespaceId scope = spaces[(i % paths.size()) * 2654435761u % spaces.size()];
+                found[cached] += table.Lookup(scope, paths[i % paths.size()]).kind;
+            }
+            sec[cached] = std::chrono::duration<double>(Clock::now() - t).count();
+        }
+        std::printf("%u namespaces | uncached %7.1f ns/lookup | cached %7.1f ns/lookup | x%.1f %s\n",
+                    namespaceCount, sec[0] * 1e9 / lookups, sec[1] * 1e9 / lookups, sec[0] / sec[1],
+                    found[0] == found[1] ? "" : "MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 100000);
+        return 0;
+    }
+
+    SymbolTable table;
+    const SymbolTable::NamespaceId global = SymbolTable::s_Global;
+
+    table.AddFunction(table.AddNamespace(global, "A"), "f");
+    table.AddFunction(table.AddNamespace(global, "B"), "f");
+
+    SymbolTable::NamespaceId myLib = table.AddNamespace(global, "MyLib");
+    table.AddFunction(table.AddNamespace(myLib, "Parser"), "Tokenizer");
+
+    SymbolTable::NamespaceId g = table.AddNamespace(global, "G");
+    SymbolTable::NamespaceId h = table.AddNamespace(global, "H");
+    table.AddFunction(g, "f");
+    table.AddFunction(h, "g");
+    SymbolTable::NamespaceId myModule = table.AddNamespace(global, "MyModule");
+    table.AddUsing(myModule, g);
+    table.AddUsing(myModule, h);
+
+    SymbolTable::NamespaceId myModule1 = table.AddNamespace(global, "MyModule1");
+    SymbolTable::NamespaceId myModule2 = table.AddNamespace(global, "MyModule2");
+    table.AddFunction(myModule1, "Test");
+    table.AddFunction(myModule2, "Test");
+    table.AddUsing(global, myModule1);      // using namespace MyModule1;
+    table.AddUsing(global, myModule2);      // using namespace MyModule2;
+    SymbolTable::NamespaceId myModule3 = table.AddNamespace(global, "MyModule3");
+
+    Print(table, global, "A::f");                       // A::f
+    Print(table, global, "B::f");                       // B::f
+    Print(table, global, "MyLib::Parser::Tokenizer");   // MyLib::Parser::Tokenizer
+    Print(table, global, "MyModule::f");                // G::f
+    Print(table, global, "MyModule::g");                // H::g
+    Print(table, myModule3, "Test");                    // ambiguous
+    Print(table, myModule3, "MyModule1::Test");         // MyModule1::Test
+    Print(table, global, "MyLib::File::Load");          // not found
+
+    // a later declaration outdates only the cached lookups of its own name
+    table.AddFunction(myModule3, "Test");
+    Print(table, myModule3, "Test");                    // MyModule3::Test
+    Print(table, global, "MyModule::f");                // G::f
+    return 0;
+}
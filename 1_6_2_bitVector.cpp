@@ -0,0 +1,366 @@
+/**
+ *          Bit Vector
+ * --------------------------------------------------
+ * 1_6_boolBOOL.cpp:
+ *      sizeof(BOOL) == sizeof(int) == 4
+ *      sizeof(bool) >= 1
+ * For a few flags that's nothing, for billions of flags it's the whole memory budget:
+ *      1G flags    BOOL 4 GB   bool 1 GB   bits 128 MB
+ *
+ * BitVector stores 1 bit per flag in uint64_t words:
+ *      Count / Rank / Select       popcount per word instead of a loop per flag
+ *      Rank index                  running count every 512 bits (one cache line of words)
+ *                                  -> Rank is O(1), Select is a binary search + one line
+ *      &= |= ^=                    64 flags per word op (AVX2: 256 per instruction)
+ *      FromBools / FromBOOLs       32 bools (or 8 BOOLs) -> bits with one compare + movemask
+ *
+ * bits past Size() are always 0, so word ops and Count never need a tail mask
+ *
+ * Usage:
+ *      1_6_2_bitVector --check [N]         // against a std::vector<bool>
+ *      1_6_2_bitVector --bench [M]         // M million flags: memory, count and conversion speed
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+typedef int BOOL;       // Visual C++ typedef int BOOL;
+
+class BitVector {
+    static constexpr size_t s_WordsPerBlock = 8;        // 512 bits, one cache line
+
+    std::vector<uint64_t> m_Words;
+    size_t m_Size = 0;
+    mutable std::vector<uint64_t> m_BlockRank;          // set bits before each block
+    mutable bool m_IndexValid = false;
+
+public:
+    BitVector() = default;
+    explicit BitVector(size_t size, bool value = false) { Resize(size, value); }
+
+    size_t Size() const { return m_Size; }
+    size_t Bytes() const { return m_Words.size() * sizeof(uint64_t); }
+    const uint64_t* Words() const { return m_Words.data(); }
+
+    void Resize(size_t size, bool value = false) {
+        size_t old = m_Size;
+        m_Words.resize((size + 63) / 64, 0);
+        m_Size = size;
+        if (value) {
+            for (size_t i = old; i < size && i % 64 != 0; ++i) {
+                Set(i);
+            }
+            std::fill(m_Words.begin() + static_cast<std::ptrdiff_t>((old + 63) / 64), m_Words.end(), ~0ull);
+        }
+        ClearTail();
+        m_IndexValid = false;
+    }
+
+    bool Get(size_t i) const { return (m_Words[i / 64] >> (i % 64)) & 1; }
+    bool operator [](size_t i) const { return Get(i); }
+
+    void Set(size_t i) { m_Words[i / 64] |= 1ull << (i % 64); m_IndexValid = false; }
+    void Reset(size_t i) { m_Words[i / 64] &= ~(1ull << (i % 64)); m_IndexValid = false; }
+    void Flip(size_t i) { m_Words[i / 64] ^= 1ull << (i % 64); m_IndexValid = false; }
+    void Assign(size_t i, bool value) { value ? Set(i) : Reset(i); }
+
+    // number of set bits
+    size_t Count() const {
+        size_t count = 0;
+        for (uint64_t word : m_Words) {
+            count += static_cast<size_t>(PopCount(word));
+        }
+        return count;
+    }
+
+    // number of set bits in [0, i), i <= Size()
+    size_t Rank(size_t i) const {
+        BuildIndex();
+        size_t word = i / 64;
+        size_t block = word / s_WordsPerBlock;
+        size_t rank = m_BlockRank[block];
+        for (size_t w = block * s_WordsPerBlock; w < word; ++w) {
+            rank += static_cast<size_t>(PopCount(m_Words[w]));
+        }
+        if (i % 64 != 0) {
+            rank += static_cast<size_t>(PopCount(m_Words[word] & ((1ull << (i % 64)) - 1)));
+        }
+        return rank;
+    }
+
+    // position of the k-th set bit (k from 0), Size() if there are not that many
+    size_t Select(size_t k) const {
+        BuildIndex();
+        if (k >= m_BlockRank.back()) {
+            return m_Size;
+        }
+        // last block whose running count is <= k
+        size_t block = static_cast<size_t>(std::upper_bound(m_BlockRank.begin(), m_BlockRank.end(), k) - m_BlockRank.begin()) - 1;
+        k -= m_BlockRank[block];
+        for (size_t w = block * s_WordsPerBlock; ; ++w) {
+            size_t count = static_cast<size_t>(PopCount(m_Words[w]));
+            if (k < count) {
+                return w * 64 + static_cast<size_t>(SelectInWord(m_Words[w], static_cast<unsigned>(k)));
+            }
+            k -= count;
+        }
+    }
+
+    // sizes have to match
+    BitVector& operator &=(const BitVector& other) { Combine(other, [](auto a, auto b) { return a & b; }); return *this; }
+    BitVector& operator |=(const BitVector& other) { Combine(other, [](auto a, auto b) { return a | b; }); return *this; }
+    BitVector& operator ^=(const BitVector& other) { Combine(other, [](auto a, auto b) { return a ^ b; }); return *this; }
+
+    // any nonzero byte is true (a bool that came through memcpy or a union can be 2~255)
+    static BitVector FromBools(const bool* flags, size_t count) {
+        BitVector bits(count);
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(flags);
+        size_t i = 0;
+#if defined(__AVX2__)
+        for (; i + 64 <= count; i += 64) {
+            __m256i zero = _mm256_setzero_si256();
+            __m256i lo = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i)), zero);
+            __m256i hi = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i + 32)), zero);
+            uint64_t isZero = static_cast<uint32_t>(_mm256_movemask_epi8(lo)) |
+                              static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(hi))) << 32;
+            bits.m_Words[i / 64] = ~isZero;
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        for (; i + 64 <= count; i += 64) {
+            uint64_t isZero = 0;
+            for (int part = 0; part < 4; ++part) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i + part * 16));
+                isZero |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()))) << (part * 16);
+            }
+            bits.m_Words[i / 64] = ~isZero;
+        }
+#endif
+        for (; i < count; ++i) {
+            bits.m_Words[i / 64] |= static_cast<uint64_t>(bytes[i] != 0) << (i % 64);
+        }
+        return bits;
+    }
+
+    // TRUE is anything but 0, like if (b) does it
+    static BitVector FromBOOLs(const BOOL* flags, size_t count) {
+        BitVector bits(count);
+        size_t i = 0;
+#if defined(__AVX2__)
+        for (; i + 64 <= count; i += 64) {
+            uint64_t isZero = 0;
+            for (int part = 0; part < 8; ++part) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(flags + i + part * 8));
+                __m256 zero = _mm256_castsi256_ps(_mm256_cmpeq_epi32(v, _mm256_setzero_si256()));
+                isZero |= static_cast<uint64_t>(_mm256_movemask_ps(zero)) << (part * 8);
+            }
+            bits.m_Words[i / 64] = ~isZero;
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        for (; i + 64 <= count; i += 64) {
+            uint64_t isZero = 0;
+            for (int part = 0; part < 16; ++part) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(flags + i + part * 4));
+                __m128 zero = _mm_castsi128_ps(_mm_cmpeq_epi32(v, _mm_setzero_si128()));
+                isZero |= static_cast<uint64_t>(_mm_movemask_ps(zero)) << (part * 4);
+            }
+            bits.m_Words[i / 64] = ~isZero;
+        }
+#endif
+        for (; i < count; ++i) {
+            bits.m_Words[i / 64] |= static_cast<uint64_t>(flags[i] != 0) << (i % 64);
+        }
+        return bits;
+    }
+
+    void ToBools(bool* out) const {
+        for (size_t i = 0; i < m_Size; ++i) {
+            out[i] = Get(i);
+        }
+    }
+
+private:
+    static int PopCount(uint64_t x) {
+#if defined(_MSC_VER)
+        return static_cast<int>(__popcnt64(x));
+#else
+        return __builtin_popcountll(x);
+#endif
+    }
+
+    // index of the k-th set bit of word, k < PopCount(word)
+    static int SelectInWord(uint64_t word, unsigned k) {
+#if defined(__BMI2__)
+        return static_cast<int>(_tzcnt_u64(_pdep_u64(1ull << k, word)));
+#else
+        for (; k != 0; --k) {
+            word &= word - 1;
+        }
+        return __builtin_ctzll(word);
+#endif
+    }
+
+    void ClearTail() {
+        if (m_Size % 64 != 0) {
+            m_Words.back() &= (1ull << (m_Size % 64)) - 1;
+        }
+    }
+
+    void BuildIndex() const {
+        if (m_IndexValid) {
+            return;
+        }
+        size_t blocks = (m_Words.size() + s_WordsPerBlock - 1) / s_WordsPerBlock;
+        m_BlockRank.assign(blocks + 1, 0);
+        size_t rank = 0;
+        for (size_t w = 0; w < m_Words.size(); ++w) {
+            if (w % s_WordsPerBlock == 0) {
+                m_BlockRank[w / s_WordsPerBlock] = rank;
+            }
+            rank += static_cast<size_t>(PopCount(m_Words[w]));
+        }
+        m_BlockRank[blocks] = rank;     // total, also the sentinel for Select
+        m_IndexValid = true;
+    }
+
+    // op works on both uint64_t and __m256i (the bitwise operators are defined for GCC/Clang vectors)
+    template <class Op>
+    void Combine(const BitVector& other, Op op) {
+        size_t n = std::min(m_Words.size(), other.m_Words.size());
+        uint64_t* a = m_Words.data();
+        const uint64_t* b = other.m_Words.data();
+        size_t i = 0;
+#if defined(__AVX2__) && !defined(_MSC_VER)
+        for (; i + 4 <= n; i += 4) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), op(x, y));
+        }
+#endif
+        for (; i < n; ++i) {
+            a[i] = op(a[i], b[i]);
+        }
+        m_IndexValid = false;
+    }
+};
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    unsigned int g_Seed = 12345;
+    unsigned int Random() {
+        g_Seed = g_Seed * 1103515245u + 12345u;
+        return g_Seed >> 8;
+    }
+
+    bool Check(size_t count) {
+        bool ok = true;
+        for (size_t size : {size_t(0), size_t(1), size_t(63), size_t(64), size_t(65), size_t(511), size_t(512), size_t(513), count}) {
+            std::vector<BOOL> legacy(size);
+            std::unique_ptr<bool[]> flags(new bool[size + 1]);
+            std::vector<bool> reference(size), other(size);
+            for (size_t i = 0; i < size; ++i) {
+                legacy[i] = Random() % 3 == 0 ? static_cast<BOOL>(Random()) : 0;   // TRUE isn't always 1
+                flags[i] = legacy[i] != 0;
+                reference[i] = legacy[i] != 0;
+                other[i] = Random() % 2 == 0;
+            }
+            BitVector a = BitVector::FromBOOLs(legacy.data(), size);
+            BitVector b = BitVector::FromBools(flags.get(), size);
+            BitVector c(size);
+            for (size_t i = 0; i < size; ++i) {
+                c.Assign(i, other[i]);
+            }
+
+            size_t rank = 0;
+            for (size_t i = 0; i < size; ++i) {
+                ok = ok && a.Rank(i) == rank && a[i] == reference[i] && b[i] == reference[i];
+                if (reference[i]) {
+                    ok = ok && a.Select(rank) == i;
+                    ++rank;
+                }
+            }
+            ok = ok && a.Rank(size) == rank && a.Count() == rank && a.Select(rank) == size;
+
+            BitVector andBits = a, orBits = a, xorBits = a;
+            andBits &= c;
+            orBits |= c;
+            xorBits ^= c;
+            for (size_t i = 0; i < size; ++i) {
+                ok = ok && andBits[i] == (reference[i] && other[i]) && orBits[i] == (reference[i] || other[i]) &&
+                     xorBits[i] == (reference[i] != other[i]);
+            }
+            BitVector ones(size, true);
+            ok = ok && ones.Count() == size;
+        }
+        std::cout << (ok ? "ok" : "MISMATCH") << std::endl;
+        return ok;
+    }
+
+    template <class F>
+    double Seconds(F f) {
+        Clock::time_point t = Clock::now();
+        f();
+        return std::chrono::duration<double>(Clock::now() - t).count();
+    }
+
+    void Bench(size_t millions) {
+        size_t count = millions * 1000000;
+        std::vector<BOOL> legacy(count);
+        std::unique_ptr<bool[]> flags(new bool[count]);
+        for (size_t i = 0; i < count; ++i) {
+            legacy[i] = Random() % 4 == 0;
+            flags[i] = legacy[i] != 0;
+        }
+
+        BitVector bits;
+        double fromBOOL = Seconds([&]() { bits = BitVector::FromBOOLs(legacy.data(), count); });
+        double fromBool = Seconds([&]() { bits = BitVector::FromBools(flags.get(), count); });
+
+        size_t counted[3];
+        double sec[3];
+        sec[0] = Seconds([&]() { counted[0] = static_cast<size_t>(std::count_if(legacy.begin(), legacy.end(), [](BOOL b) { return b != 0; })); });
+        sec[1] = Seconds([&]() { counted[1] = static_cast<size_t>(std::count(flags.get(), flags.get() + count, true)); });
+        sec[2] = Seconds([&]() { counted[2] = bits.Count(); });
+
+        size_t selected = 0;
+        double select = Seconds([&]() {
+            for (size_t i = 0; i < 1000000; ++i) {
+                selected += bits.Select(Random() % counted[2]);
+            }
+        });
+
+        std::printf("%zu flags | memory BOOL %zu MB, bool %zu MB, bits %zu MB\n", count,
+                    count * sizeof(BOOL) >> 20, count * sizeof(bool) >> 20, bits.Bytes() >> 20);
+        std::printf("count    | BOOL %7.2f ms | bool %7.2f ms | bits %7.2f ms %s\n", sec[0] * 1e3, sec[1] * 1e3, sec[2] * 1e3,
+                    counted[0] == counted[1] && counted[1] == counted[2] ? "" : "MISMATCH");
+        std::printf("convert  | BOOL -> bits %.2f GB/s in | bool -> bits %.2f GB/s in\n",
+                    count * sizeof(BOOL) / fromBOOL / 1e9, count / fromBool / 1e9);
+        std::printf("select   | %.1f ns (%zu)\n", select * 1e9 / 1000000, selected % 10);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+        return Check(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 100000) ? 0 : 1;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 64);
+        return 0;
+    }
+
+    BOOL legacy[] = {1, 0, 0, 1, 1, 0, -1, 0};     // -1 is TRUE too
+    BitVector bits = BitVector::FromBOOLs(legacy, 8);
+    std::cout << "count " << bits.Count() << ", rank(4) " << bits.Rank(4) << ", select(2) " << bits.Select(2) << std::endl;    // 4, 2, 4
+    return 0;
+}
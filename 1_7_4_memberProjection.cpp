@@ -0,0 +1,265 @@
+/**
+ *          Member Projection
+ * --------------------------------------------------
+ * 1_7_2_morePointer.cpp:
+ *      int Base::* p10 = &Base::m_Value;   // "the m_Value field of some Base"
+ *      b.*p10 = 10;
+ * A member pointer names a field without naming an object - exactly what a column is.
+ *
+ * Projection<&Particle::x, &Particle::y, &Particle::mass> copies those fields out of an array of
+ * objects into one contiguous array per field (Gather), and back (Scatter):
+ *      no copy loop written by hand per field, the member list is the whole spec
+ *      the member pointers are template arguments -> field offset and object stride are
+ *      compile time constants, so 4 and 8 byte fields use
+ *          AVX2        vpgatherdd / vpgatherdq         8 (or 4) fields per instruction
+ *          AVX-512VL   vpscatterdd / vpscatterdq       for the way back
+ *      other fields (or no AVX2) use a plain loop
+ *
+ * Modern C++:
+ *  C++17~ -> template <auto M> was added, a member pointer can be a template argument without
+ *            spelling out its type
+ *
+ * Usage:
+ *      1_7_4_memberProjection --check [N]      // simd vs scalar, gather -> scatter round trip
+ *      1_7_4_memberProjection --bench [N]      // N objects, scalar vs simd GB/s
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+template <class M>
+struct MemberTraits;
+template <class C, class F>
+struct MemberTraits<F C::*> {
+    typedef C Class;
+    typedef F Field;
+};
+
+template <auto First, auto... Rest>
+class Projection {
+public:
+    typedef typename MemberTraits<decltype(First)>::Class Object;
+    typedef std::tuple<std::vector<typename MemberTraits<decltype(First)>::Field>,
+                       std::vector<typename MemberTraits<decltype(Rest)>::Field>...> Columns;
+
+    static_assert((std::is_same<typename MemberTraits<decltype(Rest)>::Class, Object>::value && ...),
+                  "all members have to belong to the same class");
+
+    // columns are resized to count
+    static void Gather(const Object* objects, size_t count, Columns& columns, bool simd = true) {
+        GatherAll(objects, count, columns, simd, std::index_sequence_for<decltype(First), decltype(Rest)...>());
+    }
+
+    static Columns Gather(const Object* objects, size_t count, bool simd = true) {
+        Columns columns;
+        Gather(objects, count, columns, simd);
+        return columns;
+    }
+
+    // writes the first count values of every column back into the objects
+    static void Scatter(const Columns& columns, Object* objects, size_t count, bool simd = true) {
+        ScatterAll(columns, objects, count, simd, std::index_sequence_for<decltype(First), decltype(Rest)...>());
+    }
+
+    // one field, into / out of a raw array
+    template <auto Member>
+    static void GatherField(const Object* objects, size_t count, typename MemberTraits<decltype(Member)>::Field* out, bool simd = true) {
+        size_t i = 0;
+#if defined(__AVX2__)
+        typedef typename MemberTraits<decltype(Member)>::Field Field;
+        if (simd && count > 0) {
+            if constexpr (Gatherable<Field>() && sizeof(Field) == 4) {
+                const __m256i index = StrideIndex8();
+                for (; i + 8 <= count; i += 8) {
+                    const int* base = reinterpret_cast<const int*>(&(objects[i].*Member));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_i32gather_epi32(base, index, 1));
+                }
+            } else if constexpr (Gatherable<Field>() && sizeof(Field) == 8) {
+                const __m128i index = StrideIndex4();
+                for (; i + 4 <= count; i += 4) {
+                    const long long* base = reinterpret_cast<const long long*>(&(objects[i].*Member));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_i32gather_epi64(base, index, 1));
+                }
+            }
+        }
+#endif
+        (void)simd;
+        for (; i < count; ++i) {
+            out[i] = objects[i].*Member;
+        }
+    }
+
+    template <auto Member>
+    static void ScatterField(const typename MemberTraits<decltype(Member)>::Field* in, Object* objects, size_t count, bool simd = true) {
+        size_t i = 0;
+#if defined(__AVX512F__) && defined(__AVX512VL__)
+        typedef typename MemberTraits<decltype(Member)>::Field Field;
+        if (simd && count > 0) {
+            if constexpr (Gatherable<Field>() && sizeof(Field) == 4) {
+                const __m256i index = StrideIndex8();
+                for (; i + 8 <= count; i += 8) {
+                    int* base = reinterpret_cast<int*>(&(objects[i].*Member));
+                    _mm256_i32scatter_epi32(base, index, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), 1);
+                }
+            } else if constexpr (Gatherable<Field>() && sizeof(Field) == 8) {
+                const __m128i index = StrideIndex4();
+                for (; i + 4 <= count; i += 4) {
+                    long long* base = reinterpret_cast<long long*>(&(objects[i].*Member));
+                    _mm256_i32scatter_epi64(base, index, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), 1);
+                }
+            }
+        }
+#endif
+        (void)simd;
+        for (; i < count; ++i) {
+            objects[i].*Member = in[i];
+        }
+    }
+
+private:
+    // plain bits that can be moved as int / long long (int, float, double, pointers, ...)
+    template <class Field>
+    static constexpr bool Gatherable() {
+        return std::is_trivially_copyable<Field>::value && (sizeof(Field) == 4 || sizeof(Field) == 8) &&
+               sizeof(Object) * 8 < 0x7FFFFFFF;    // byte offsets of 8 objects fit the int32 index
+    }
+
+#if defined(__AVX2__)
+    static __m256i StrideIndex8() {
+        const int s = static_cast<int>(sizeof(Object));
+        return _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+    }
+    static __m128i StrideIndex4() {
+        const int s = static_cast<int>(sizeof(Object));
+        return _mm_setr_epi32(0, s, 2 * s, 3 * s);
+    }
+#endif
+
+    template <size_t... I>
+    static void GatherAll(const Object* objects, size_t count, Columns& columns, bool simd, std::index_sequence<I...>) {
+        constexpr auto members = std::make_tuple(First, Rest...);
+        ((std::get<I>(columns).resize(count),
+          GatherField<std::get<I>(members)>(objects, count, std::get<I>(columns).data(), simd)), ...);
+    }
+
+    template <size_t... I>
+    static void ScatterAll(const Columns& columns, Object* objects, size_t count, bool simd, std::index_sequence<I...>) {
+        constexpr auto members = std::make_tuple(First, Rest...);
+        (ScatterField<std::get<I>(members)>(std::get<I>(columns).data(), objects, count, simd), ...);
+    }
+};
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    struct Particle {
+        int id;
+        float x, y, z;
+        float vx, vy, vz;
+        double mass;
+        char name[20];
+    };
+
+    typedef Projection<&Particle::id, &Particle::x, &Particle::y, &Particle::mass> Fields;
+
+    std::vector<Particle> MakeParticles(size_t count) {
+        std::vector<Particle> particles(count);
+        for (size_t i = 0; i < count; ++i) {
+            Particle& p = particles[i];
+            p.id = static_cast<int>(i);
+            p.x = i * 0.5f;
+            p.y = i * -0.25f;
+            p.z = 1.0f;
+            p.vx = p.vy = p.vz = 0.0f;
+            p.mass = 1.0 + i % 7;
+            std::snprintf(p.name, sizeof(p.name), "p%zu", i);
+        }
+        return particles;
+    }
+
+    bool Check(size_t count) {
+        bool ok = true;
+        for (size_t n : {size_t(0), size_t(1), size_t(7), size_t(9), count}) {
+            std::vector<Particle> particles = MakeParticles(n);
+            Fields::Columns scalar = Fields::Gather(particles.data(), n, false);
+            Fields::Columns simd = Fields::Gather(particles.data(), n, true);
+            ok = ok && scalar == simd;
+
+            for (size_t i = 0; i < n; ++i) {
+                std::get<1>(simd)[i] += 1.0f;
+                std::get<3>(simd)[i] *= 2.0;
+            }
+            std::vector<Particle> copy = particles;
+            Fields::Scatter(simd, particles.data(), n, true);
+            for (size_t i = 0; i < n; ++i) {
+                ok = ok && particles[i].x == copy[i].x + 1.0f && particles[i].mass == copy[i].mass * 2.0 &&
+                     particles[i].id == copy[i].id && particles[i].z == copy[i].z &&
+                     std::strcmp(particles[i].name, copy[i].name) == 0;
+            }
+        }
+        std::cout << (ok ? "ok" : "MISMATCH") << std::endl;
+        return ok;
+    }
+
+    template <class F>
+    double Seconds(F f) {
+        Clock::time_point t = Clock::now();
+        f();
+        return std::chrono::duration<double>(Clock::now() - t).count();
+    }
+
+    void Bench(size_t count) {
+        std::vector<Particle> particles = MakeParticles(count);
+        Fields::Columns columns;
+        Fields::Gather(particles.data(), count, columns);      // size the columns once
+
+        const int rounds = 10;
+        double gather[2], scatter[2];
+        for (int simd = 0; simd < 2; ++simd) {
+            gather[simd] = Seconds([&]() {
+                for (int r = 0; r < rounds; ++r) {
+                    Fields::Gather(particles.data(), count, columns, simd == 1);
+                }
+            });
+            scatter[simd] = Seconds([&]() {
+                for (int r = 0; r < rounds; ++r) {
+                    Fields::Scatter(columns, particles.data(), count, simd == 1);
+                }
+            });
+        }
+        // bytes of field data moved per round (int + float + float + double)
+        double gb = count * (sizeof(int) + 2 * sizeof(float) + sizeof(double)) * rounds / 1e9;
+        std::printf("%zu objects (%zu bytes each) | gather scalar %.2f GB/s simd %.2f GB/s | scatter scalar %.2f GB/s simd %.2f GB/s\n",
+                    count, sizeof(Particle), gb / gather[0], gb / gather[1], gb / scatter[0], gb / scatter[1]);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+        return Check(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 100000) ? 0 : 1;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 4000000);
+        return 0;
+    }
+
+    std::vector<Particle> particles = MakeParticles(4);
+    Projection<&Particle::x, &Particle::mass>::Columns columns = Projection<&Particle::x, &Particle::mass>::Gather(particles.data(), 4);
+    for (float x : std::get<0>(columns)) {
+        std::cout << x << " ";          // 0 0.5 1 1.5
+    }
+    std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,300 @@
+/**
+ *          Slot Map
+ * --------------------------------------------------
+ * 1_7_pointer_ref.cpp lists the ways a pointer/reference outlives its object:
+ *      int& result = GetX();       // refers to a destroyed local
+ *      int& r = *p;                // p is NULL
+ *      int** pp                    // two levels that can both go stale
+ * With objects that are created and destroyed all the time (entities, connections, timers) a raw
+ * pointer kept somewhere else is exactly that bug waiting to happen.
+ *
+ * SlotMap<T> hands out a 64 bit Handle {slot index, generation} instead:
+ *      Get(handle)     nullptr if the object was erased, even if the slot got reused
+ *                      (every erase bumps the generation of the slot, old handles stop matching)
+ *      objects         dense std::vector<T>, erase moves the last object into the hole
+ *                      -> iteration is a plain array walk, no holes, no scattered new
+ *      free slots      linked through the slot array itself (intrusive free list), no extra memory
+ *
+ *      handle --> m_Slots[index] {generation, dense index} --> m_Objects[dense index]
+ *
+ * Usage:
+ *      1_7_5_slotMap                   // stale handle example
+ *      1_7_5_slotMap --check [N]       // N random insert/erase/get against std::unordered_map
+ *      1_7_5_slotMap --bench [N]       // iteration + lookup vs new'ed objects
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Handle {
+    uint64_t m_Value = 0;       // 0 is never a valid handle (generations start at 1)
+public:
+    Handle() = default;
+    Handle(uint32_t index, uint32_t generation) : m_Value(static_cast<uint64_t>(generation) << 32 | index) {}
+
+    uint32_t Index() const { return static_cast<uint32_t>(m_Value); }
+    uint32_t Generation() const { return static_cast<uint32_t>(m_Value >> 32); }
+    uint64_t Value() const { return m_Value; }
+    explicit operator bool() const { return m_Value != 0; }
+
+    bool operator ==(const Handle& other) const { return m_Value == other.m_Value; }
+    bool operator !=(const Handle& other) const { return m_Value != other.m_Value; }
+};
+
+template <class T>
+class SlotMap {
+    static constexpr uint32_t s_End = 0xFFFFFFFF;
+
+    struct Slot {
+        uint32_t generation;
+        uint32_t link;          // live: index into m_Objects, free: next free slot
+    };
+
+    std::vector<Slot> m_Slots;
+    std::vector<T> m_Objects;
+    std::vector<uint32_t> m_ObjectSlot;     // m_Objects[i] lives in m_Slots[m_ObjectSlot[i]]
+    uint32_t m_FreeHead = s_End;
+
+public:
+    size_t Size() const { return m_Objects.size(); }
+    bool Empty() const { return m_Objects.empty(); }
+
+    void Reserve(size_t count) {
+        m_Slots.reserve(count);
+        m_Objects.reserve(count);
+        m_ObjectSlot.reserve(count);
+    }
+
+    template <class... Args>
+    Handle Emplace(Args&&... args) {
+        uint32_t slot;
+        if (m_FreeHead != s_End) {
+            slot = m_FreeHead;
+            m_FreeHead = m_Slots[slot].link;
+        } else {
+            slot = static_cast<uint32_t>(m_Slots.size());
+            m_Slots.push_back(Slot{1, 0});
+        }
+        m_Objects.emplace_back(std::forward<Args>(args)...);
+        m_ObjectSlot.push_back(slot);
+        m_Slots[slot].link = static_cast<uint32_t>(m_Objects.size() - 1);
+        return Handle(slot, m_Slots[slot].generation);
+    }
+
+    Handle Insert(const T& value) { return Emplace(value); }
+    Handle Insert(T&& value) { return Emplace(std::move(value)); }
+
+    // nullptr for a stale or null handle
+    T* Get(Handle handle) {
+        uint32_t index = handle.Index();
+        // a retired slot has generation 0, which no handle but the null one carries
+        if (index >= m_Slots.size() || m_Slots[index].generation != handle.Generation() || handle.Generation() == 0) {
+            return nullptr;
+        }
+        return &m_Objects[m_Slots[index].link];
+    }
+    const T* Get(Handle handle) const { return const_cast<SlotMap*>(this)->Get(handle); }
+
+    bool Contains(Handle handle) const { return Get(handle) != nullptr; }
+
+    // false if the handle was already stale
+    bool Erase(Handle handle) {
+        if (!Contains(handle)) {
+            return false;
+        }
+        uint32_t slot = handle.Index();
+        uint32_t hole = m_Slots[slot].link;
+        uint32_t last = static_cast<uint32_t>(m_Objects.size() - 1);
+        if (hole != last) {
+            m_Objects[hole] = std::move(m_Objects[last]);
+            m_ObjectSlot[hole] = m_ObjectSlot[last];
+            m_Slots[m_ObjectSlot[hole]].link = hole;
+        }
+        m_Objects.pop_back();
+        m_ObjectSlot.pop_back();
+
+        // a slot whose generation would wrap to 0 is retired instead of reused
+        if (++m_Slots[slot].generation != 0) {
+            m_Slots[slot].link = m_FreeHead;
+            m_FreeHead = slot;
+        }
+        return true;
+    }
+
+    void Clear() {
+        for (size_t i = 0; i < m_ObjectSlot.size(); ++i) {
+            Slot& slot = m_Slots[m_ObjectSlot[i]];
+            if (++slot.generation != 0) {
+                slot.link = m_FreeHead;
+                m_FreeHead = m_ObjectSlot[i];
+            }
+        }
+        m_Objects.clear();
+        m_ObjectSlot.clear();
+    }
+
+    // the handle of the object at a position of the dense array (e.g. while iterating)
+    Handle HandleAt(size_t position) const {
+        uint32_t slot = m_ObjectSlot[position];
+        return Handle(slot, m_Slots[slot].generation);
+    }
+
+    // dense iteration, the order changes on erase
+    typename std::vector<T>::iterator begin() { return m_Objects.begin(); }
+    typename std::vector<T>::iterator end() { return m_Objects.end(); }
+    typename std::vector<T>::const_iterator begin() const { return m_Objects.begin(); }
+    typename std::vector<T>::const_iterator end() const { return m_Objects.end(); }
+};
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entity {
+        float x = 0, y = 0;
+        float vx = 1, vy = 2;
+        int hp = 100;
+        int id = 0;
+    };
+
+    bool Check(size_t steps) {
+        SlotMap<int> map;
+        std::unordered_map<uint64_t, int> reference;
+        std::vector<Handle> handles;        // live and dead, to poke with stale ones
+        std::mt19937 random(7);
+        bool ok = true;
+        for (size_t i = 0; i < steps && ok; ++i) {
+            unsigned op = random() % 10;
+            if (op < 5 || handles.empty()) {
+                int value = static_cast<int>(random());
+                Handle h = map.Insert(value);
+                ok = ok && reference.find(h.Value()) == reference.end();   // never the same handle twice
+                reference[h.Value()] = value;
+                handles.push_back(h);
+            } else if (op < 8) {
+                Handle h = handles[random() % handles.size()];
+                bool erased = map.Erase(h);
+                ok = ok && erased == (reference.erase(h.Value()) == 1);
+            } else {
+                Handle h = handles[random() % handles.size()];
+                const int* p = map.Get(h);
+                auto it = reference.find(h.Value());
+                ok = ok && (p == nullptr) == (it == reference.end()) && (p == nullptr || *p == it->second);
+            }
+        }
+        long long sum = 0, expected = 0;
+        for (int value : map) {
+            sum += value;
+        }
+        for (const auto& entry : reference) {
+            expected += entry.second;
+        }
+        for (size_t i = 0; i < map.Size(); ++i) {
+            ok = ok && reference.count(map.HandleAt(i).Value()) == 1;
+        }
+        ok = ok && map.Size() == reference.size() && sum == expected && !map.Contains(Handle());
+
+        std::cout << steps << " ops, " << map.Size() << " live | " << (ok ? "ok" : "MISMATCH") << std::endl;
+        return ok;
+    }
+
+    template <class F>
+    double Seconds(F f) {
+        Clock::time_point t = Clock::now();
+        f();
+        return std::chrono::duration<double>(Clock::now() - t).count();
+    }
+
+    void Bench(size_t count) {
+        std::mt19937 random(42);
+
+        // both sides go through the same churn: fill, erase half at random, fill again
+        std::vector<std::unique_ptr<Entity>> owned;
+        SlotMap<Entity> map;
+        std::vector<Handle> handles;
+        for (size_t i = 0; i < count; ++i) {
+            owned.push_back(std::make_unique<Entity>());
+            handles.push_back(map.Emplace());
+        }
+        for (size_t i = 0; i < count / 2; ++i) {
+            size_t victim = random() % owned.size();
+            std::swap(owned[victim], owned.back());
+            owned.pop_back();
+            std::swap(handles[victim], handles.back());
+            map.Erase(handles.back());
+            handles.pop_back();
+        }
+        for (size_t i = 0; i < count / 2; ++i) {
+            owned.push_back(std::make_unique<Entity>());
+            handles.push_back(map.Emplace());
+        }
+        std::vector<Entity*> pointers;
+        for (const std::unique_ptr<Entity>& e : owned) {
+            pointers.push_back(e.get());
+        }
+        std::shuffle(pointers.begin(), pointers.end(), random);
+        std::shuffle(handles.begin(), handles.end(), random);
+
+        const int rounds = 10;
+        double iterate[2], lookup[2];
+        iterate[0] = Seconds([&]() {
+            for (int r = 0; r < rounds; ++r) {
+                for (Entity* e : pointers) {
+                    e->x += e->vx;
+                    e->y += e->vy;
+                }
+            }
+        });
+        iterate[1] = Seconds([&]() {
+            for (int r = 0; r < rounds; ++r) {
+                for (Entity& e : map) {
+                    e.x += e.vx;
+                    e.y += e.vy;
+                }
+            }
+        });
+        // random access: pointer deref vs handle -> slot -> object
+        long long sum[2] = {0, 0};
+        lookup[0] = Seconds([&]() {
+            for (Entity* e : pointers) {
+                sum[0] += e->hp;
+            }
+        });
+        lookup[1] = Seconds([&]() {
+            for (Handle h : handles) {
+                sum[1] += map.Get(h)->hp;
+            }
+        });
+
+        double n = static_cast<double>(count);
+        std::printf("%zu objects | iterate: new'ed %.2f ns, slot map %.2f ns | random lookup: pointer %.2f ns, handle %.2f ns %s\n",
+                    count, iterate[0] * 1e9 / (n * rounds), iterate[1] * 1e9 / (n * rounds),
+                    lookup[0] * 1e9 / n, lookup[1] * 1e9 / n, sum[0] == sum[1] ? "" : "MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+        return Check(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 1000000) ? 0 : 1;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 2000000);
+        return 0;
+    }
+
+    SlotMap<int> map;
+    Handle x = map.Insert(10);
+    map.Erase(x);                           // like the local in GetX() going away
+    Handle y = map.Insert(20);              // reuses the slot of x
+    std::cout << (map.Get(x) == nullptr ? "x is stale" : "x is alive?!") << ", y = " << *map.Get(y) << std::endl;
+    return 0;
+}
@@ -0,0 +1,284 @@
+/**
+ *          Delegate
+ * --------------------------------------------------
+ * 1_7_2_morePointer.cpp has three kinds of "thing to call":
+ *      void (*p7)(int) = &TestFunc;        // function pointer
+ *      void (&r6)(int) = TestFunc;         // function reference
+ *      void (Base::* p11)() = &Base::f;    // member function pointer, needs an object: (b.*p11)()
+ * An event system wants one type for all of them plus small lambdas. std::function does that, but
+ * it heap-allocates once the callable is bigger than its internal buffer (16 bytes in libstdc++) and
+ * every copy goes through a manager function.
+ *
+ * Delegate<R(Args...)> = 24 byte inline buffer + one stub pointer (32 bytes total)
+ *      Delegate(TestFunc)                  free function, pointer kept in the buffer
+ *      Delegate::Bind<&Base::f>(&b)        member known at compile time, only the object in the buffer
+ *      Delegate(&b, p11)                   member pointer at runtime, object + member pointer (8 + 16)
+ *      Delegate([=](int x) {...})          lambda/functor, trivially copyable and <= 24 bytes
+ *                                          (checked at compile time -> never a heap allocation)
+ *      copy = memcpy of 32 bytes, call = one indirect call through the stub
+ *
+ * Usage:
+ *      1_7_6_delegate                  // example
+ *      1_7_6_delegate --check          // every binding kind, and no operator new while doing it
+ *      1_7_6_delegate --bench [N]      // construct + call vs std::function and raw pointers
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+    size_t s_NewCount = 0;          // operator new calls, to prove Delegate never allocates
+}
+
+void* operator new(size_t size) {
+    ++s_NewCount;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+template <class Signature>
+class Delegate;
+
+template <class R, class... Args>
+class Delegate<R(Args...)> {
+public:
+    static constexpr size_t s_BufferSize = 24;
+
+private:
+    typedef R (*Stub)(const void* buffer, Args... args);
+
+    alignas(void*) unsigned char m_Buffer[s_BufferSize];
+    Stub m_Stub = nullptr;
+
+    template <class F>
+    static R CallFunctor(const void* buffer, Args... args) {
+        return (*static_cast<F*>(const_cast<void*>(buffer)))(std::forward<Args>(args)...);
+    }
+
+    template <class T, R (T::*Method)(Args...)>
+    static R CallMethod(const void* buffer, Args... args) {
+        T* object;
+        std::memcpy(&object, buffer, sizeof(object));
+        return (object->*Method)(std::forward<Args>(args)...);
+    }
+
+    template <class T, R (T::*Method)(Args...) const>
+    static R CallConstMethod(const void* buffer, Args... args) {
+        const T* object;
+        std::memcpy(&object, buffer, sizeof(object));
+        return (object->*Method)(std::forward<Args>(args)...);
+    }
+
+    template <class T, class Method>
+    struct Bound {
+        T* object;
+        Method method;
+        R operator ()(Args... args) const { return (object->*method)(std::forward<Args>(args)...); }
+    };
+
+public:
+    Delegate() = default;
+    Delegate(std::nullptr_t) {}
+
+    // function pointer, function reference, lambda or any small trivially copyable functor
+    template <class F, class D = typename std::decay<F>::type,
+              class = typename std::enable_if<!std::is_same<D, Delegate>::value>::type>
+    Delegate(F&& func) {
+        static_assert(sizeof(D) <= s_BufferSize, "callable does not fit in the Delegate buffer");
+        static_assert(alignof(D) <= alignof(void*), "callable is over-aligned for the Delegate buffer");
+        static_assert(std::is_trivially_copyable<D>::value && std::is_trivially_destructible<D>::value,
+                      "Delegate only holds trivially copyable callables (capture pointers, not owners)");
+        ::new (static_cast<void*>(m_Buffer)) D(std::forward<F>(func));
+        m_Stub = &CallFunctor<D>;
+    }
+
+    // member function pointer known only at runtime: Delegate(&b, p11)
+    template <class T>
+    Delegate(T* object, R (T::*method)(Args...)) : Delegate(Bound<T, R (T::*)(Args...)>{object, method}) {}
+    template <class T>
+    Delegate(const T* object, R (T::*method)(Args...) const)
+        : Delegate(Bound<const T, R (T::*)(Args...) const>{object, method}) {}
+
+    // member function known at compile time: Delegate<void()>::Bind<&Base::f>(&b)
+    template <auto Method, class T>
+    static Delegate Bind(T* object) {
+        Delegate result;
+        std::memcpy(result.m_Buffer, &object, sizeof(object));
+        if constexpr (std::is_const<T>::value) {
+            result.m_Stub = &CallConstMethod<typename std::remove_const<T>::type, Method>;
+        } else {
+            result.m_Stub = &CallMethod<T, Method>;
+        }
+        return result;
+    }
+
+    explicit operator bool() const { return m_Stub != nullptr; }
+
+    R operator ()(Args... args) const {
+        return m_Stub(m_Buffer, std::forward<Args>(args)...);
+    }
+};
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    int s_Total = 0;
+    void TestFunc(int x) { s_Total += x; }
+
+    class Base {
+    public:
+        int m_Value = 0;
+        virtual ~Base() = default;
+        virtual void f() { std::cout << "Base" << std::endl; }
+        void Add(int x) { m_Value += x; }
+        int Get() const { return m_Value; }
+    };
+    class Derived : public Base {
+    public:
+        void f() override { std::cout << "Derived" << std::endl; }
+    };
+
+    bool Check() {
+        bool ok = true;
+        size_t before = s_NewCount;
+
+        s_Total = 0;
+        void (*p7)(int) = &TestFunc;
+        void (&r6)(int) = TestFunc;
+        Delegate<void(int)> d1(p7), d2(r6), d3(TestFunc);
+        d1(1);
+        d2(2);
+        d3(3);
+        ok = ok && s_Total == 6;
+
+        Base b;
+        void (Base::* add)(int) = &Base::Add;
+        Delegate<void(int)> d4(&b, add);
+        Delegate<void(int)> d5 = Delegate<void(int)>::Bind<&Base::Add>(&b);
+        d4(10);
+        d5(20);
+        ok = ok && b.m_Value == 30;
+
+        const Base& cb = b;
+        Delegate<int()> d6(&cb, &Base::Get);
+        Delegate<int()> d7 = Delegate<int()>::Bind<&Base::Get>(&cb);
+        ok = ok && d6() == 30 && d7() == 30;
+
+        int a = 1, c = 2, e = 3;            // 3 pointers = 24 bytes, std::function would allocate
+        int* pa = &a;
+        int* pc = &c;
+        int* pe = &e;
+        Delegate<int(int)> d8([pa, pc, pe](int x) { return *pa + *pc + *pe + x; });
+        Delegate<int(int)> d9 = d8;         // copy
+        ok = ok && d9(4) == 10;
+
+        Delegate<void(int)> empty;
+        ok = ok && !empty && d1;
+
+        ok = ok && s_NewCount == before && sizeof(Delegate<void(int)>) == 32;
+        std::cout << "bindings " << (ok ? "ok" : "MISMATCH") << ", "
+                  << s_NewCount - before << " allocations, sizeof " << sizeof(Delegate<void(int)>) << std::endl;
+        return ok;
+    }
+
+    template <class F>
+    double Seconds(F f) {
+        Clock::time_point t = Clock::now();
+        f();
+        return std::chrono::duration<double>(Clock::now() - t).count();
+    }
+
+    // construct count callbacks (a 24 byte capture, like object + member pointer) and call each once
+    template <class Callback>
+    void Measure(const char* name, size_t count) {
+        std::vector<Callback> callbacks;
+        callbacks.reserve(count);
+        std::vector<long long> targets(64);
+        long long* base = targets.data();
+        long long step = 3;
+
+        size_t before = s_NewCount;
+        double build = Seconds([&]() {
+            for (size_t i = 0; i < count; ++i) {
+                long long* target = base + (i & 63);
+                long long* amount = &step;
+                int* unused = nullptr;
+                callbacks.emplace_back([target, amount, unused](int x) { *target += *amount + x + (unused != nullptr); });
+            }
+        });
+        size_t allocations = s_NewCount - before;
+        double call = Seconds([&]() {
+            for (const Callback& callback : callbacks) {
+                callback(1);
+            }
+        });
+        long long sum = 0;
+        for (long long t : targets) {
+            sum += t;
+        }
+        double n = static_cast<double>(count);
+        std::printf("  %-22s construct %6.2f ns, call %5.2f ns, %zu allocations %s\n", name,
+                    build * 1e9 / n, call * 1e9 / n, allocations,
+                    sum == static_cast<long long>(count) * 4 ? "" : "MISMATCH");
+    }
+
+    void MeasurePointer(size_t count) {
+        std::vector<void (*)(int)> callbacks;
+        callbacks.reserve(count);
+        s_Total = 0;
+        double build = Seconds([&]() {
+            for (size_t i = 0; i < count; ++i) {
+                callbacks.push_back(&TestFunc);
+            }
+        });
+        double call = Seconds([&]() {
+            for (void (*callback)(int) : callbacks) {
+                callback(1);
+            }
+        });
+        double n = static_cast<double>(count);
+        std::printf("  %-22s construct %6.2f ns, call %5.2f ns %s\n", "raw function pointer",
+                    build * 1e9 / n, call * 1e9 / n, s_Total == static_cast<int>(count) ? "" : "MISMATCH");
+    }
+
+    void Bench(size_t count) {
+        std::printf("%zu callbacks\n", count);
+        MeasurePointer(count);
+        Measure<Delegate<void(int)>>("Delegate", count);
+        Measure<std::function<void(int)>>("std::function", count);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+        return Check() ? 0 : 1;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 4000000);
+        return 0;
+    }
+
+    Derived d;
+    Base* p9 = &d;
+    void (Base::* p11)() = &Base::f;
+    Delegate<void()> onEvent(p9, p11);      // virtual dispatch still applies: prints Derived
+    onEvent();
+    onEvent = Delegate<void()>::Bind<&Base::f>(p9);
+    onEvent();
+    onEvent = []() { std::cout << "lambda" << std::endl; };
+    onEvent();
+    return 0;
+}
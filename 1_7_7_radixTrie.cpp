@@ -0,0 +1,362 @@
+/**
+ *          Radix Trie
+ * --------------------------------------------------
+ * 1_7_2_morePointer.cpp:
+ *      int** pp = &p;          // pointer to pointer
+ * Sparse lookup tables get built from that by hand: table[key >> 16][key & 0xFFFF], every level
+ *      malloc'ed up front or checked for NULL at every use.
+ *
+ * RadixTrie<T, Bits...> is the page table version of it:
+ *      key split into fixed fields, one level per field, e.g. RadixTrie<int, 8, 12, 12> for 32 bit keys
+ *      interior node = array of child pointers, leaf = present bitmap + values
+ *      nodes are only allocated when a key under them is inserted
+ *          -> memory grows with the populated key ranges, not with the 2^32 / 2^64 key space
+ *      Find = one dependent load per level (3 for RadixArray32, 4 for RadixArray64), no hashing,
+ *          no probing, no rehash
+ *      FindBatch = walks a group of keys level by level and prefetches the next level of every
+ *          key while the others are loading, so the misses overlap instead of queueing
+ *          (a plain Find loop gets most of that from out-of-order execution already when nothing
+ *          else is in the loop; the batch keeps the overlap when the caller's loop body is heavy)
+ *
+ * Erase clears the present bit; nodes stay until Clear() or the destructor.
+ *
+ * Usage:
+ *      1_7_7_radixTrie --check [N]     // N random operations against std::unordered_map
+ *      1_7_7_radixTrie --bench [N]     // N clustered keys: Find / FindBatch / unordered_map, memory
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define RADIX_PREFETCH(p) _mm_prefetch(reinterpret_cast<const char*>(p), _MM_HINT_T0)
+#else
+#define RADIX_PREFETCH(p) ((void)(p))
+#endif
+
+template <class T, unsigned... Bits>
+class RadixTrie {
+public:
+    static constexpr unsigned s_Levels = sizeof...(Bits);
+    static constexpr unsigned s_KeyBits = (Bits + ...);
+    typedef typename std::conditional<(s_KeyBits > 32), uint64_t, uint32_t>::type Key;
+
+private:
+    static_assert(s_Levels >= 2 && s_Levels <= 4, "2 ~ 4 levels");
+    static_assert(s_KeyBits == 32 || s_KeyBits == 64, "the fields have to cover a 32 or 64 bit key");
+
+    static constexpr unsigned s_Bits[s_Levels] = {Bits...};
+    static constexpr unsigned s_LeafBits = s_Bits[s_Levels - 1];
+    static constexpr size_t s_LeafSize = size_t(1) << s_LeafBits;
+
+    struct Leaf {
+        uint64_t present[(s_LeafSize + 63) / 64] = {};
+        T values[s_LeafSize] = {};
+    };
+
+    size_t m_Size = 0;
+    size_t m_Bytes = 0;     // before m_Root: NewNode(0) in the constructor already counts into it
+    void** m_Root;
+
+    static constexpr unsigned Shift(unsigned level) {
+        unsigned shift = 0;
+        for (unsigned l = level + 1; l < s_Levels; ++l) {
+            shift += s_Bits[l];
+        }
+        return shift;
+    }
+    static size_t Index(Key key, unsigned level) {
+        return static_cast<size_t>(key >> Shift(level)) & ((size_t(1) << s_Bits[level]) - 1);
+    }
+
+    void** NewNode(unsigned level) {
+        m_Bytes += (size_t(1) << s_Bits[level]) * sizeof(void*);
+        return new void*[size_t(1) << s_Bits[level]]();
+    }
+
+    void Free(void** node, unsigned level) {
+        size_t count = size_t(1) << s_Bits[level];
+        for (size_t i = 0; i < count; ++i) {
+            if (node[i] == nullptr) {
+                continue;
+            }
+            if (level + 2 == s_Levels) {
+                delete static_cast<Leaf*>(node[i]);
+            } else {
+                Free(static_cast<void**>(node[i]), level + 1);
+            }
+        }
+        delete[] node;
+    }
+
+    // the leaf that holds key, created on the way down when create is set
+    Leaf* FindLeaf(Key key, bool create) {
+        void** node = m_Root;
+        for (unsigned level = 0; level + 1 < s_Levels; ++level) {
+            void*& child = node[Index(key, level)];
+            if (child == nullptr) {
+                if (!create) {
+                    return nullptr;
+                }
+                if (level + 2 == s_Levels) {
+                    child = new Leaf();
+                    m_Bytes += sizeof(Leaf);
+                } else {
+                    child = NewNode(level + 1);
+                }
+            }
+            if (level + 2 == s_Levels) {
+                return static_cast<Leaf*>(child);
+            }
+            node = static_cast<void**>(child);
+        }
+        return nullptr;
+    }
+
+public:
+    RadixTrie() : m_Root(NewNode(0)) {}
+    ~RadixTrie() { Free(m_Root, 0); }
+    RadixTrie(const RadixTrie&) = delete;
+    RadixTrie& operator =(const RadixTrie&) = delete;
+
+    size_t Size() const { return m_Size; }
+    size_t MemoryBytes() const { return m_Bytes; }
+
+    // the value for key, default constructed and inserted if it was not there
+    T& operator [](Key key) {
+        Leaf* leaf = FindLeaf(key, true);
+        size_t i = Index(key, s_Levels - 1);
+        uint64_t bit = uint64_t(1) << (i % 64);
+        if ((leaf->present[i / 64] & bit) == 0) {
+            leaf->present[i / 64] |= bit;
+            leaf->values[i] = T();
+            ++m_Size;
+        }
+        return leaf->values[i];
+    }
+
+    void Insert(Key key, const T& value) { (*this)[key] = value; }
+
+    // nullptr if key is not there
+    T* Find(Key key) {
+        void* node = m_Root;
+        for (unsigned level = 0; level + 1 < s_Levels; ++level) {
+            node = static_cast<void**>(node)[Index(key, level)];
+            if (node == nullptr) {
+                return nullptr;
+            }
+        }
+        Leaf* leaf = static_cast<Leaf*>(node);
+        size_t i = Index(key, s_Levels - 1);
+        return (leaf->present[i / 64] >> (i % 64) & 1) != 0 ? &leaf->values[i] : nullptr;
+    }
+    const T* Find(Key key) const { return const_cast<RadixTrie*>(this)->Find(key); }
+
+    bool Erase(Key key) {
+        Leaf* leaf = FindLeaf(key, false);
+        if (leaf == nullptr) {
+            return false;
+        }
+        size_t i = Index(key, s_Levels - 1);
+        uint64_t bit = uint64_t(1) << (i % 64);
+        if ((leaf->present[i / 64] & bit) == 0) {
+            return false;
+        }
+        leaf->present[i / 64] &= ~bit;
+        leaf->values[i] = T();
+        --m_Size;
+        return true;
+    }
+
+    void Clear() {
+        Free(m_Root, 0);
+        m_Bytes = 0;
+        m_Root = NewNode(0);
+        m_Size = 0;
+    }
+
+    // out[i] = Find(keys[i]); groups of s_Group keys go down one level at a time together
+    void FindBatch(const Key* keys, size_t count, T** out) {
+        static constexpr size_t s_Group = 16;
+        void* nodes[s_Group];
+        for (size_t base = 0; base < count; base += s_Group) {
+            size_t n = count - base < s_Group ? count - base : s_Group;
+            for (size_t g = 0; g < n; ++g) {
+                nodes[g] = m_Root;
+            }
+            for (unsigned level = 0; level + 1 < s_Levels; ++level) {
+                bool leafNext = level + 2 == s_Levels;
+                for (size_t g = 0; g < n; ++g) {
+                    if (nodes[g] == nullptr) {
+                        continue;
+                    }
+                    Key key = keys[base + g];
+                    void* child = static_cast<void**>(nodes[g])[Index(key, level)];
+                    nodes[g] = child;
+                    if (child == nullptr) {
+                        continue;
+                    }
+                    if (leafNext) {
+                        size_t i = Index(key, level + 1);
+                        RADIX_PREFETCH(&static_cast<Leaf*>(child)->present[i / 64]);
+                        RADIX_PREFETCH(&static_cast<Leaf*>(child)->values[i]);
+                    } else {
+                        RADIX_PREFETCH(&static_cast<void**>(child)[Index(key, level + 1)]);
+                    }
+                }
+            }
+            for (size_t g = 0; g < n; ++g) {
+                T* value = nullptr;
+                if (nodes[g] != nullptr) {
+                    Leaf* leaf = static_cast<Leaf*>(nodes[g]);
+                    size_t i = Index(keys[base + g], s_Levels - 1);
+                    if ((leaf->present[i / 64] >> (i % 64) & 1) != 0) {
+                        value = &leaf->values[i];
+                    }
+                }
+                out[base + g] = value;
+            }
+        }
+    }
+};
+
+template <class T>
+using RadixArray32 = RadixTrie<T, 8, 12, 12>;           // 3 loads: 2 KB root, 32 KB nodes, 4K value leaves
+template <class T>
+using RadixArray64 = RadixTrie<T, 16, 16, 16, 16>;      // 4 loads: 512 KB root and nodes, 64K value leaves
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    template <class Trie, class Make>
+    bool CheckTrie(const char* name, size_t steps, Make makeKey) {
+        Trie trie;
+        std::unordered_map<typename Trie::Key, int> reference;
+        std::vector<typename Trie::Key> keys;
+        std::mt19937_64 random(9);
+        bool ok = true;
+        for (size_t i = 0; i < steps && ok; ++i) {
+            unsigned op = random() % 10;
+            typename Trie::Key key = (op % 2 == 0 && !keys.empty()) ? keys[random() % keys.size()] : makeKey(random);
+            if (op < 5) {
+                int value = static_cast<int>(random());
+                trie.Insert(key, value);
+                reference[key] = value;
+                keys.push_back(key);
+            } else if (op < 7) {
+                ok = ok && trie.Erase(key) == (reference.erase(key) == 1);
+            } else {
+                const int* p = trie.Find(key);
+                auto it = reference.find(key);
+                ok = ok && (p == nullptr) == (it == reference.end()) && (p == nullptr || *p == it->second);
+            }
+        }
+        std::vector<int*> batch(keys.size());
+        trie.FindBatch(keys.data(), keys.size(), batch.data());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            auto it = reference.find(keys[i]);
+            ok = ok && (batch[i] == nullptr) == (it == reference.end()) && (batch[i] == nullptr || *batch[i] == it->second);
+        }
+        ok = ok && trie.Size() == reference.size();
+        size_t size = trie.Size(), bytes = trie.MemoryBytes();
+        trie.Clear();
+        ok = ok && trie.Size() == 0 && trie.MemoryBytes() == Trie().MemoryBytes();     // the root is counted either way
+        std::cout << name << ": " << steps << " ops, " << size << " keys, "
+                  << (bytes >> 10) << " KB | " << (ok ? "ok" : "MISMATCH") << std::endl;
+        return ok;
+    }
+
+    bool Check(size_t steps) {
+        // keys in a few clusters plus a few anywhere, so both shared and lone nodes show up
+        // (a lone 64 bit key costs three 512 KB nodes: the trie is for clustered keys)
+        bool ok32 = CheckTrie<RadixArray32<int>>("32 bit", steps, [](std::mt19937_64& r) {
+            return r() % 64 == 0 ? static_cast<uint32_t>(r()) : static_cast<uint32_t>((r() % 8) << 28 | (r() % 20000));
+        });
+        bool ok64 = CheckTrie<RadixArray64<int>>("64 bit", steps / 10, [](std::mt19937_64& r) {
+            return r() % 256 == 0 ? r() : (r() % 4) << 60 | (r() % 100000);
+        });
+        return ok32 && ok64;
+    }
+
+    template <class F>
+    double Seconds(F f) {
+        Clock::time_point t = Clock::now();
+        f();
+        return std::chrono::duration<double>(Clock::now() - t).count();
+    }
+
+    void Bench(size_t count) {
+        std::mt19937_64 random(1);
+        RadixArray32<uint32_t> trie;
+        std::unordered_map<uint32_t, uint32_t> map;
+        std::vector<uint32_t> keys(count);
+        // 256 clusters spread over the whole 32 bit range, dense inside a cluster
+        for (uint32_t& key : keys) {
+            key = static_cast<uint32_t>((random() % 256) << 24 | (random() % (count / 64 + 1)));
+            trie.Insert(key, key ^ 0x5A5A5A5A);
+            map[key] = key ^ 0x5A5A5A5A;
+        }
+        std::vector<uint32_t> lookups(count);
+        for (uint32_t& key : lookups) {
+            key = keys[random() % keys.size()];
+        }
+
+        uint64_t sum[3] = {0, 0, 0};
+        double seconds[3];
+        seconds[0] = Seconds([&]() {
+            for (uint32_t key : lookups) {
+                sum[0] += *trie.Find(key);
+            }
+        });
+        seconds[1] = Seconds([&]() {
+            uint32_t* out[256];         // a chunk at a time, the results stay in L1
+            for (size_t base = 0; base < count; base += 256) {
+                size_t n = count - base < 256 ? count - base : 256;
+                trie.FindBatch(lookups.data() + base, n, out);
+                for (size_t i = 0; i < n; ++i) {
+                    sum[1] += *out[i];
+                }
+            }
+        });
+        seconds[2] = Seconds([&]() {
+            for (uint32_t key : lookups) {
+                sum[2] += map.find(key)->second;
+            }
+        });
+
+        double n = static_cast<double>(count);
+        size_t flatBytes = (size_t(1) << 32) * sizeof(uint32_t);
+        std::printf("%zu keys (%zu distinct) | Find %.2f ns, FindBatch %.2f ns, unordered_map %.2f ns %s\n",
+                    count, trie.Size(), seconds[0] * 1e9 / n, seconds[1] * 1e9 / n, seconds[2] * 1e9 / n,
+                    sum[0] == sum[1] && sum[1] == sum[2] ? "" : "MISMATCH");
+        std::printf("memory: trie %zu MB, flat table over the key range %zu MB\n",
+                    trie.MemoryBytes() >> 20, flatBytes >> 20);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+        return Check(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 1000000) ? 0 : 1;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 4000000);
+        return 0;
+    }
+
+    RadixArray64<int> table;
+    table[0x7FFF000000001234ull] = 20;      // two keys ~2^63 apart, a few nodes each
+    table[42] = 10;
+    const int* missing = table.Find(43);
+    std::cout << table[42] << " " << table[0x7FFF000000001234ull] << " " << (missing == nullptr ? "(43 not there)" : "?")
+              << ", " << (table.MemoryBytes() >> 10) << " KB" << std::endl;
+    return 0;
+}
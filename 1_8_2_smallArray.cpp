@@ -0,0 +1,376 @@
+/**
+ *          Small Array
+ * --------------------------------------------------
+ * 1_8_array.cpp allocates and copies by hand:
+ *      int* p = new int[5];
+ *      delete[] p;
+ *      for (int i = 0; ...) arr2[i] = arr1[i];
+ * Most of our arrays hold fewer than 16 elements, so the new/delete round trip costs more than the
+ * work done with the array.
+ *
+ * SmallArray<T, N> = vector interface with the first N elements stored inside the object
+ *      size <= N           no heap at all
+ *      size > N            heap block aligned to 64 bytes (one cache line, full AVX-512 register)
+ *      trivial T           growth and copy are memcpy, ResizeUninitialized() skips zero-filling
+ *                          when the caller is about to overwrite everything anyway
+ *      other T             placement new / move / destroy like std::vector
+ *
+ * Usage:
+ *      1_8_2_smallArray                // example
+ *      1_8_2_smallArray --check [N]    // N random operations against std::vector
+ *      1_8_2_smallArray --bench [N]    // N short-lived arrays vs new[] and std::vector
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <class T, size_t N = 16>
+class SmallArray {
+    static_assert(N > 0, "SmallArray needs at least one inline element, use std::vector for none");
+
+public:
+    static constexpr size_t s_HeapAlignment = 64;
+
+private:
+    static constexpr bool s_Trivial = std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value;
+    static constexpr size_t s_Alignment = alignof(T) > s_HeapAlignment ? alignof(T) : s_HeapAlignment;
+
+    T* m_Data;
+    size_t m_Size = 0;
+    size_t m_Capacity = N;
+    alignas(T) unsigned char m_Inline[N * sizeof(T)];
+
+    bool IsInline() const { return m_Data == reinterpret_cast<const T*>(m_Inline); }
+
+    static T* Allocate(size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(s_Alignment)));
+    }
+    static void Deallocate(T* p) {
+        ::operator delete(p, std::align_val_t(s_Alignment));
+    }
+
+    // count elements from src to uninitialized dst, src is left destroyed
+    static void Relocate(T* dst, T* src, size_t count) {
+        if constexpr (s_Trivial) {
+            if (count != 0) {
+                std::memcpy(static_cast<void*>(dst), src, count * sizeof(T));
+            }
+        } else {
+            std::uninitialized_move(src, src + count, dst);
+            std::destroy(src, src + count);
+        }
+    }
+
+    // moves into the new block and frees the old one
+    void Adopt(T* data, size_t capacity) {
+        Relocate(data, m_Data, m_Size);
+        if (!IsInline()) {
+            Deallocate(m_Data);
+        }
+        m_Data = data;
+        m_Capacity = capacity;
+    }
+
+    void Grow(size_t minimum) {
+        size_t capacity = std::max(minimum, m_Capacity * 2);
+        Adopt(Allocate(capacity), capacity);
+    }
+
+    // full array: the new element is built in the new block first, args may point into the old one
+    template <class... Args>
+    T& GrowEmplace(Args&&... args) {
+        size_t capacity = m_Capacity * 2;
+        T* data = Allocate(capacity);
+        T* p;
+        try {
+            p = ::new (static_cast<void*>(data + m_Size)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            Deallocate(data);
+            throw;
+        }
+        Adopt(data, capacity);
+        ++m_Size;
+        return *p;
+    }
+
+    void CopyFrom(const SmallArray& other) {
+        Reserve(other.m_Size);
+        if constexpr (s_Trivial) {
+            if (other.m_Size != 0) {
+                std::memcpy(static_cast<void*>(m_Data), other.m_Data, other.m_Size * sizeof(T));
+            }
+        } else {
+            std::uninitialized_copy(other.m_Data, other.m_Data + other.m_Size, m_Data);
+        }
+        m_Size = other.m_Size;
+    }
+
+    // takes the heap block, or relocates the inline elements; other is left empty
+    void MoveFrom(SmallArray& other) {
+        if (other.IsInline()) {
+            Relocate(m_Data, other.m_Data, other.m_Size);
+        } else {
+            m_Data = other.m_Data;
+            m_Capacity = other.m_Capacity;
+            other.m_Data = reinterpret_cast<T*>(other.m_Inline);
+            other.m_Capacity = N;
+        }
+        m_Size = other.m_Size;
+        other.m_Size = 0;
+    }
+
+    void Release() {
+        Clear();
+        if (!IsInline()) {
+            Deallocate(m_Data);
+        }
+        m_Data = reinterpret_cast<T*>(m_Inline);
+        m_Capacity = N;
+    }
+
+public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    SmallArray() : m_Data(reinterpret_cast<T*>(m_Inline)) {}
+    explicit SmallArray(size_t count) : SmallArray() { Resize(count); }
+    SmallArray(std::initializer_list<T> values) : SmallArray() {
+        Reserve(values.size());
+        std::uninitialized_copy(values.begin(), values.end(), m_Data);
+        m_Size = values.size();
+    }
+    SmallArray(const SmallArray& other) : SmallArray() { CopyFrom(other); }
+    SmallArray(SmallArray&& other) noexcept : SmallArray() { MoveFrom(other); }
+    ~SmallArray() { Release(); }
+
+    SmallArray& operator =(const SmallArray& other) {
+        if (this != &other) {
+            Clear();
+            CopyFrom(other);
+        }
+        return *this;
+    }
+    SmallArray& operator =(SmallArray&& other) noexcept {
+        if (this != &other) {
+            Release();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    size_t Size() const { return m_Size; }
+    size_t Capacity() const { return m_Capacity; }
+    bool Empty() const { return m_Size == 0; }
+    bool OnHeap() const { return !IsInline(); }
+
+    T* Data() { return m_Data; }
+    const T* Data() const { return m_Data; }
+    T& operator [](size_t i) { return m_Data[i]; }
+    const T& operator [](size_t i) const { return m_Data[i]; }
+    T& Back() { return m_Data[m_Size - 1]; }
+
+    iterator begin() { return m_Data; }
+    iterator end() { return m_Data + m_Size; }
+    const_iterator begin() const { return m_Data; }
+    const_iterator end() const { return m_Data + m_Size; }
+
+    void Reserve(size_t count) {
+        if (count > m_Capacity) {
+            Grow(count);
+        }
+    }
+
+    template <class... Args>
+    T& Emplace(Args&&... args) {
+        if (m_Size == m_Capacity) {
+            return GrowEmplace(std::forward<Args>(args)...);
+        }
+        T* p = ::new (static_cast<void*>(m_Data + m_Size)) T(std::forward<Args>(args)...);
+        ++m_Size;
+        return *p;
+    }
+    void Push(const T& value) { Emplace(value); }
+    void Push(T&& value) { Emplace(std::move(value)); }
+
+    void Pop() {
+        --m_Size;
+        m_Data[m_Size].~T();
+    }
+
+    // new elements are value-initialized (0 for int)
+    void Resize(size_t count) {
+        if (count > m_Size) {
+            Reserve(count);
+            std::uninitialized_value_construct(m_Data + m_Size, m_Data + count);
+        } else {
+            std::destroy(m_Data + count, m_Data + m_Size);
+        }
+        m_Size = count;
+    }
+
+    // new elements keep whatever the memory had, for a buffer that is filled right after
+    void ResizeUninitialized(size_t count) {
+        static_assert(std::is_trivial<T>::value, "ResizeUninitialized needs a trivial type");
+        Reserve(count);
+        m_Size = count;
+    }
+
+    void Clear() {
+        std::destroy(m_Data, m_Data + m_Size);
+        m_Size = 0;
+    }
+};
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    template <class Array>
+    bool Same(const Array& array, const std::vector<typename Array::value_type>& reference) {
+        return array.Size() == reference.size() && std::equal(array.begin(), array.end(), reference.begin());
+    }
+
+    template <class T, class Make>
+    bool CheckType(size_t steps, Make make) {
+        SmallArray<T, 4> array;
+        std::vector<T> reference;
+        std::mt19937 random(5);
+        bool ok = true;
+        for (size_t i = 0; i < steps && ok; ++i) {
+            unsigned op = random() % 10;
+            if (op < 5) {
+                T value = make(random());
+                array.Push(value);
+                reference.push_back(value);
+                if (array.Size() == array.Capacity()) {
+                    array.Push(array[0]);       // argument lives in the block that is about to be freed
+                    reference.push_back(reference[0]);
+                }
+            } else if (op < 7) {
+                if (!reference.empty()) {
+                    array.Pop();
+                    reference.pop_back();
+                }
+            } else if (op < 8) {
+                size_t count = random() % 24;
+                array.Resize(count);
+                reference.resize(count);
+            } else if (op < 9) {
+                SmallArray<T, 4> copy(array);
+                SmallArray<T, 4> moved(std::move(copy));
+                ok = ok && Same(moved, reference) && copy.Empty();
+                array = std::move(moved);
+            } else {
+                SmallArray<T, 4> copy;
+                copy = array;
+                array = copy;
+            }
+            ok = ok && Same(array, reference);
+            ok = ok && (!array.OnHeap() || reinterpret_cast<uintptr_t>(array.Data()) % 64 == 0);
+        }
+        return ok;
+    }
+
+    bool Check(size_t steps) {
+        bool trivial = CheckType<int>(steps, [](uint32_t r) { return static_cast<int>(r); });
+        bool strings = CheckType<std::string>(steps, [](uint32_t r) { return std::string(r % 40, 'a' + r % 26); });
+        std::cout << steps << " ops | int " << (trivial ? "ok" : "MISMATCH")
+                  << ", std::string " << (strings ? "ok" : "MISMATCH") << std::endl;
+        return trivial && strings;
+    }
+
+    template <class F>
+    double Seconds(F f) {
+        Clock::time_point t = Clock::now();
+        f();
+        return std::chrono::duration<double>(Clock::now() - t).count();
+    }
+
+    // the barrier keeps the compiler from proving the allocation unused and removing it
+    template <class T>
+    void Escape(T* p) {
+        asm volatile("" : : "g"(p) : "memory");
+    }
+
+    void Bench(size_t count) {
+        std::mt19937 random(3);
+        std::vector<unsigned> sizes(count);
+        for (unsigned& size : sizes) {
+            size = 1 + random() % 16;
+        }
+        long long sum[3] = {0, 0, 0};
+        double seconds[3];
+
+        seconds[0] = Seconds([&]() {
+            for (unsigned size : sizes) {
+                int* p = new int[size];
+                Escape(p);
+                for (unsigned i = 0; i < size; ++i) {
+                    p[i] = static_cast<int>(i);
+                }
+                sum[0] += p[size - 1];
+                delete[] p;
+            }
+        });
+        seconds[1] = Seconds([&]() {
+            for (unsigned size : sizes) {
+                std::vector<int> v(size);
+                Escape(v.data());
+                for (unsigned i = 0; i < size; ++i) {
+                    v[i] = static_cast<int>(i);
+                }
+                sum[1] += v[size - 1];
+            }
+        });
+        seconds[2] = Seconds([&]() {
+            for (unsigned size : sizes) {
+                SmallArray<int> a;
+                a.ResizeUninitialized(size);
+                Escape(a.Data());
+                for (unsigned i = 0; i < size; ++i) {
+                    a[i] = static_cast<int>(i);
+                }
+                sum[2] += a[size - 1];
+            }
+        });
+
+        double n = static_cast<double>(count);
+        std::printf("%zu arrays of 1~16 ints | new[]/delete[] %.2f ns, std::vector %.2f ns, SmallArray %.2f ns %s\n",
+                    count, seconds[0] * 1e9 / n, seconds[1] * 1e9 / n, seconds[2] * 1e9 / n,
+                    sum[0] == sum[1] && sum[1] == sum[2] ? "" : "MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+        return Check(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 200000) ? 0 : 1;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 10000000);
+        return 0;
+    }
+
+    SmallArray<int, 5> arr1 = {1, 2, 3};
+    SmallArray<int, 5> arr2 = arr1;         // memcpy instead of the index loop
+    arr2.Push(4);
+    arr2.Push(5);
+    std::cout << "5 elements, heap: " << arr2.OnHeap();
+    arr2.Push(6);                           // 6th element leaves the inline storage
+    std::cout << " | 6 elements, heap: " << arr2.OnHeap()
+              << ", 64 byte aligned: " << (reinterpret_cast<uintptr_t>(arr2.Data()) % 64 == 0) << std::endl;
+    return 0;
+}
@@ -0,0 +1,320 @@
+/**
+ *          Stream Copy / Fill
+ * --------------------------------------------------
+ * 1_8_array.cpp copies one element at a time:
+ *      for (int i = 0; i < sizeof(arr1) / sizeof(int); ++i) arr2[i] = arr1[i];
+ * On buffers of hundreds of MB every normal store first reads the destination line into the cache
+ *      (read for ownership) and then pushes useful data out of the LLC for a buffer nobody reads soon.
+ *
+ * Copy(dst, src, count) / Fill(dst, value, count)
+ *      small                       SIMD loop unrolled x4, tail done with one overlapping
+ *                                  (unaligned) store that ends exactly at the last byte, all inlined
+ *      bytes >= StreamThreshold()  non-temporal stores (movntdq): no read for ownership, the lines
+ *                                  go to memory without being cached, sfence at the end
+ *      StreamThreshold() = half the L3 (sysconf), at most 32 MB (the L3 is shared with the other
+ *                          cores), 8 MB when the size is unknown
+ *      Copy between s_InlineCopyLimit and the threshold calls memcpy: glibc picks rep movsb or
+ *      64 byte stores there, which beats a 32 byte AVX loop (see --bench)
+ *
+ * AVX -> 32 byte vectors, otherwise SSE2 16 byte vectors.
+ * Fill takes 1/2/4/8 byte element types (the value is broadcast into a vector).
+ *
+ * Usage:
+ *      1_8_3_streamCopy --check                // every size 0~1K and unaligned offsets against memcpy/fill
+ *      1_8_3_streamCopy --bench [max MB]       // 64 B ~ 1 GB sweep vs memcpy/std::copy/memset/std::fill
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+#if defined(__unix__)
+#include <unistd.h>
+#endif
+
+namespace Stream {
+#if defined(__AVX__)
+    typedef __m256i Vec;
+    inline Vec Load(const void* p) { return _mm256_loadu_si256(static_cast<const __m256i*>(p)); }
+    inline void Store(void* p, Vec v) { _mm256_storeu_si256(static_cast<__m256i*>(p), v); }
+    inline void StoreNt(void* p, Vec v) { _mm256_stream_si256(static_cast<__m256i*>(p), v); }
+    template <class T>
+    inline Vec Broadcast(T value) {
+        Vec v;
+        T lanes[sizeof(Vec) / sizeof(T)];
+        std::fill(lanes, lanes + sizeof(Vec) / sizeof(T), value);
+        std::memcpy(&v, lanes, sizeof(v));
+        return v;
+    }
+#else
+    typedef __m128i Vec;
+    inline Vec Load(const void* p) { return _mm_loadu_si128(static_cast<const __m128i*>(p)); }
+    inline void Store(void* p, Vec v) { _mm_storeu_si128(static_cast<__m128i*>(p), v); }
+    inline void StoreNt(void* p, Vec v) { _mm_stream_si128(static_cast<__m128i*>(p), v); }
+    template <class T>
+    inline Vec Broadcast(T value) {
+        Vec v;
+        T lanes[sizeof(Vec) / sizeof(T)];
+        std::fill(lanes, lanes + sizeof(Vec) / sizeof(T), value);
+        std::memcpy(&v, lanes, sizeof(v));
+        return v;
+    }
+#endif
+    constexpr size_t s_Width = sizeof(Vec);
+    constexpr size_t s_InlineCopyLimit = 128;      // bytes, below this the inlined loop beats a memcpy call
+
+    inline size_t& ThresholdStorage() {
+        static size_t threshold = []() -> size_t {
+            long l3 = 0;
+#if defined(_SC_LEVEL3_CACHE_SIZE)
+            l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+            return l3 > 0 ? std::min(static_cast<size_t>(l3) / 2, size_t(32) << 20) : size_t(8) << 20;
+        }();
+        return threshold;
+    }
+    inline size_t StreamThreshold() { return ThresholdStorage(); }
+    inline void SetStreamThreshold(size_t bytes) { ThresholdStorage() = bytes; }
+
+    // below one vector: overlapping pairs of 16/8/4 byte moves, bytes one by one under 4
+    inline void CopyShort(uint8_t* dst, const uint8_t* src, size_t bytes) {
+        if (bytes >= 16) {
+            std::memcpy(dst, src, 16);      // only with 32 byte vectors
+            std::memcpy(dst + bytes - 16, src + bytes - 16, 16);
+        } else if (bytes >= 8) {
+            uint64_t a, b;
+            std::memcpy(&a, src, 8);
+            std::memcpy(&b, src + bytes - 8, 8);
+            std::memcpy(dst, &a, 8);
+            std::memcpy(dst + bytes - 8, &b, 8);
+        } else if (bytes >= 4) {
+            uint32_t a, b;
+            std::memcpy(&a, src, 4);
+            std::memcpy(&b, src + bytes - 4, 4);
+            std::memcpy(dst, &a, 4);
+            std::memcpy(dst + bytes - 4, &b, 4);
+        } else {
+            for (size_t i = 0; i < bytes; ++i) {
+                dst[i] = src[i];
+            }
+        }
+    }
+
+    // cached stores, any size
+    inline void CopyBytesCached(void* dstVoid, const void* srcVoid, size_t bytes) {
+        uint8_t* dst = static_cast<uint8_t*>(dstVoid);
+        const uint8_t* src = static_cast<const uint8_t*>(srcVoid);
+        if (bytes < s_Width) {
+            CopyShort(dst, src, bytes);
+            return;
+        }
+        Vec last = Load(src + bytes - s_Width);
+        size_t i = 0;
+        for (; i + 4 * s_Width <= bytes; i += 4 * s_Width) {
+            Vec a = Load(src + i);
+            Vec b = Load(src + i + s_Width);
+            Vec c = Load(src + i + 2 * s_Width);
+            Vec d = Load(src + i + 3 * s_Width);
+            Store(dst + i, a);
+            Store(dst + i + s_Width, b);
+            Store(dst + i + 2 * s_Width, c);
+            Store(dst + i + 3 * s_Width, d);
+        }
+        for (; i + s_Width <= bytes; i += s_Width) {
+            Store(dst + i, Load(src + i));
+        }
+        Store(dst + bytes - s_Width, last);
+    }
+
+    // non-temporal stores, bytes >= 4 vectors
+    inline void CopyBytesStream(void* dstVoid, const void* srcVoid, size_t bytes) {
+        uint8_t* dst = static_cast<uint8_t*>(dstVoid);
+        const uint8_t* src = static_cast<const uint8_t*>(srcVoid);
+        if (bytes < 4 * s_Width) {
+            CopyBytesCached(dst, src, bytes);
+            return;
+        }
+        // one unaligned head store, then dst is vector aligned as movntdq needs
+        Vec last = Load(src + bytes - s_Width);
+        Store(dst, Load(src));
+        size_t i = s_Width - reinterpret_cast<uintptr_t>(dst) % s_Width;
+        for (; i + 4 * s_Width <= bytes; i += 4 * s_Width) {
+            Vec a = Load(src + i);
+            Vec b = Load(src + i + s_Width);
+            Vec c = Load(src + i + 2 * s_Width);
+            Vec d = Load(src + i + 3 * s_Width);
+            StoreNt(dst + i, a);
+            StoreNt(dst + i + s_Width, b);
+            StoreNt(dst + i + 2 * s_Width, c);
+            StoreNt(dst + i + 3 * s_Width, d);
+        }
+        for (; i + s_Width <= bytes; i += s_Width) {
+            StoreNt(dst + i, Load(src + i));
+        }
+        _mm_sfence();       // streaming stores are weakly ordered
+        Store(dst + bytes - s_Width, last);
+    }
+
+    // pattern is value broadcast into a vector, bytes is a multiple of the element size
+    inline void FillBytes(uint8_t* dst, Vec pattern, size_t bytes, bool stream) {
+        size_t i = 0;
+        if (stream) {
+            Store(dst, pattern);
+            i = s_Width - reinterpret_cast<uintptr_t>(dst) % s_Width;
+            for (; i + 4 * s_Width <= bytes; i += 4 * s_Width) {
+                StoreNt(dst + i, pattern);
+                StoreNt(dst + i + s_Width, pattern);
+                StoreNt(dst + i + 2 * s_Width, pattern);
+                StoreNt(dst + i + 3 * s_Width, pattern);
+            }
+            for (; i + s_Width <= bytes; i += s_Width) {
+                StoreNt(dst + i, pattern);
+            }
+            _mm_sfence();
+        } else {
+            for (; i + 4 * s_Width <= bytes; i += 4 * s_Width) {
+                Store(dst + i, pattern);
+                Store(dst + i + s_Width, pattern);
+                Store(dst + i + 2 * s_Width, pattern);
+                Store(dst + i + 3 * s_Width, pattern);
+            }
+            for (; i + s_Width <= bytes; i += s_Width) {
+                Store(dst + i, pattern);
+            }
+        }
+        Store(dst + bytes - s_Width, pattern);
+    }
+
+    // dst and src must not overlap
+    template <class T>
+    void Copy(T* dst, const T* src, size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "Copy needs a trivially copyable type");
+        size_t bytes = count * sizeof(T);
+        if (bytes < s_InlineCopyLimit) {
+            CopyBytesCached(dst, src, bytes);
+        } else if (bytes >= StreamThreshold()) {
+            CopyBytesStream(dst, src, bytes);
+        } else {
+            std::memcpy(dst, src, bytes);
+        }
+    }
+
+    template <class T>
+    void Fill(T* dst, T value, size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8),
+                      "Fill needs a 1/2/4/8 byte element type");
+        size_t bytes = count * sizeof(T);
+        if (bytes < s_Width) {
+            for (size_t i = 0; i < count; ++i) {
+                dst[i] = value;
+            }
+            return;
+        }
+        // a naturally aligned T keeps the pattern in phase through the alignment step and the tail
+        FillBytes(reinterpret_cast<uint8_t*>(dst), Broadcast(value), bytes, bytes >= StreamThreshold() && bytes >= 4 * s_Width);
+    }
+}
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    bool Check() {
+        bool ok = true;
+        std::vector<uint8_t> src(4096), dst(4096), expected(4096);
+        for (size_t i = 0; i < src.size(); ++i) {
+            src[i] = static_cast<uint8_t>(i * 7 + 3);
+        }
+        for (int stream = 0; stream < 2; ++stream) {
+            Stream::SetStreamThreshold(stream ? 0 : ~size_t(0));
+            for (size_t offset = 0; offset < 64; offset += 5) {
+                for (size_t bytes = 0; bytes <= 1024 && ok; ++bytes) {
+                    std::fill(dst.begin(), dst.end(), 0xAA);
+                    expected = dst;
+                    std::memcpy(expected.data() + offset, src.data() + 3, bytes);
+                    Stream::Copy(dst.data() + offset, src.data() + 3, bytes);
+                    ok = ok && dst == expected;
+                }
+            }
+            std::vector<uint32_t> words(1100, 0), wordsExpected(1100, 0);
+            for (size_t offset = 0; offset < 16; offset += 3) {
+                for (size_t count = 0; count <= 1024 && ok; ++count) {
+                    std::fill(words.begin(), words.end(), 0u);
+                    std::fill(wordsExpected.begin(), wordsExpected.end(), 0u);
+                    std::fill(wordsExpected.begin() + offset, wordsExpected.begin() + offset + count, 0x12345678u);
+                    Stream::Fill(words.data() + offset, 0x12345678u, count);
+                    ok = ok && words == wordsExpected;
+                }
+            }
+        }
+        Stream::SetStreamThreshold(0);
+        std::vector<uint8_t> bytesOut(1000, 0);
+        Stream::Fill(bytesOut.data() + 1, uint8_t(9), 997);
+        ok = ok && bytesOut[0] == 0 && bytesOut[1] == 9 && bytesOut[997] == 9 && bytesOut[998] == 0;
+
+        std::cout << "copy/fill, cached and streaming, sizes 0~1K at unaligned offsets | " << (ok ? "ok" : "MISMATCH") << std::endl;
+        return ok;
+    }
+
+    // GB/s of bytes written, repeating until about 1 GB went through
+    template <class F>
+    double Rate(size_t bytes, F f) {
+        size_t reps = std::max<size_t>(1, (size_t(1) << 30) / bytes);
+        f();        // warm up (page faults, cache state)
+        Clock::time_point t = Clock::now();
+        for (size_t r = 0; r < reps; ++r) {
+            f();
+            asm volatile("" : : : "memory");
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - t).count();
+        return static_cast<double>(bytes) * static_cast<double>(reps) / seconds / 1e9;
+    }
+
+    void Bench(size_t maxBytes) {
+        std::vector<uint32_t> src(maxBytes / 4, 1), dst(maxBytes / 4, 0);
+        size_t threshold = Stream::StreamThreshold();
+        std::printf("stream threshold %zu KB, %zu byte vectors, GB/s written\n", threshold >> 10, Stream::s_Width);
+        std::printf("%10s | %8s %8s %8s %8s %8s | %8s %8s %8s %8s\n", "bytes", "memcpy", "std::copy",
+                    "cached", "stream", "Copy", "memset", "std::fill", "Fill", "");
+        for (size_t bytes = 64; bytes <= maxBytes; bytes *= 4) {
+            size_t count = bytes / 4;
+            uint32_t* d = dst.data();
+            const uint32_t* s = src.data();
+            double memcpyRate = Rate(bytes, [&]() { std::memcpy(d, s, bytes); });
+            double stdCopyRate = Rate(bytes, [&]() { std::copy(s, s + count, d); });
+            double cachedRate = Rate(bytes, [&]() { Stream::CopyBytesCached(d, s, bytes); });
+            double streamRate = Rate(bytes, [&]() { Stream::CopyBytesStream(d, s, bytes); });
+            double copyRate = Rate(bytes, [&]() { Stream::Copy(d, s, count); });
+            double memsetRate = Rate(bytes, [&]() { std::memset(d, 7, bytes); });
+            double stdFillRate = Rate(bytes, [&]() { std::fill(d, d + count, 7u); });
+            double fillRate = Rate(bytes, [&]() { Stream::Fill(d, 7u, count); });
+            std::printf("%10zu | %8.2f %8.2f %8.2f %8.2f %8.2f | %8.2f %8.2f %8.2f\n", bytes, memcpyRate, stdCopyRate,
+                        cachedRate, streamRate, copyRate, memsetRate, stdFillRate, fillRate);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+        return Check() ? 0 : 1;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        size_t megabytes = argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 1024;
+        Bench(megabytes << 20);
+        return 0;
+    }
+
+    int arr1[] = {1, 2, 3};
+    int arr2[3];
+    Stream::Copy(arr2, arr1, 3);        // instead of arr2[i] = arr1[i]
+    std::cout << arr2[0] << arr2[1] << arr2[2] << std::endl;
+    return 0;
+}
@@ -0,0 +1,282 @@
+/**
+ *          Huge Page Array
+ * --------------------------------------------------
+ * 1_8_array.cpp:
+ *      int* p = new int[5];
+ *      delete[] p;
+ * In production the 5 is a few hundred million. With 4 KB pages a 4 GB array is 1M pages, the
+ *      dTLB holds ~1.5K entries, so every random access is a TLB miss and a page walk.
+ *      With 2 MB pages the same array is 2K pages.
+ *
+ * LargeArray<T>(count) picks the allocation by size:
+ *      bytes < LargeArrayThreshold (4 MB)  new T[count]() like before          -> PageMode::Heap
+ *      bigger                              anonymous mmap trimmed to a 2 MB boundary,
+ *                                          madvise(MADV_HUGEPAGE)              -> PageMode::Huge
+ *      THP "never", madvise refused,       the same mapping with 4 KB pages    -> PageMode::Small
+ *      or asked for explicitly
+ * Mode() says what was requested and set up, HugeBytes() asks the kernel (/proc/self/smaps
+ *      AnonHugePages) how much of the array really ended up on huge pages.
+ *
+ * Usage:
+ *      1_8_4_hugePage                      // THP setting and the mode a 64 MB array gets
+ *      1_8_4_hugePage --bench [MB]         // random reads, 4 KB pages vs THP (dTLB misses if perf allows)
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+enum class PageMode {Auto, Heap, Small, Huge};
+
+inline const char* PageModeName(PageMode mode) {
+    static const char* names[] = {"auto", "heap", "4 KB pages", "2 MB pages (THP)"};
+    return names[static_cast<int>(mode)];
+}
+
+namespace Huge {
+    constexpr size_t s_HugePageSize = size_t(2) << 20;
+    constexpr size_t s_LargeArrayThreshold = size_t(4) << 20;
+
+    // "always [madvise] never" -> "madvise", empty if there is no THP at all
+    inline std::string ThpSetting() {
+        std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string line;
+        std::getline(file, line);
+        size_t open = line.find('[');
+        size_t close = line.find(']');
+        return open != std::string::npos && close != std::string::npos ? line.substr(open + 1, close - open - 1) : std::string();
+    }
+
+    // AnonHugePages of the mapping that contains p, in bytes
+    inline size_t HugeBytesAt(const void* p) {
+        std::ifstream smaps("/proc/self/smaps");
+        uintptr_t address = reinterpret_cast<uintptr_t>(p);
+        std::string line;
+        bool inside = false;
+        size_t huge = 0;
+        while (std::getline(smaps, line)) {
+            unsigned long long begin, end;
+            char dash;
+            std::istringstream header(line);
+            if (header >> std::hex >> begin >> dash >> end && dash == '-') {
+                inside = begin <= address && address < end;
+            } else if (inside && line.compare(0, 14, "AnonHugePages:") == 0) {
+                huge += std::strtoull(line.c_str() + 14, nullptr, 10) * 1024;
+            }
+        }
+        return huge;
+    }
+
+#if !defined(_WIN32)
+    // a 2 MB aligned anonymous mapping: map 2 MB extra and cut off both ends
+    inline void* MapAligned(size_t bytes) {
+        size_t length = bytes + s_HugePageSize;
+        void* raw = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            return nullptr;
+        }
+        uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+        uintptr_t aligned = (begin + s_HugePageSize - 1) & ~(s_HugePageSize - 1);
+        if (aligned != begin) {
+            ::munmap(raw, aligned - begin);
+        }
+        size_t tail = begin + length - (aligned + bytes);
+        if (tail != 0) {
+            ::munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+        }
+        return reinterpret_cast<void*>(aligned);
+    }
+#endif
+}
+
+// trivial element types only: a mapping starts zeroed and is released without destructors
+template <class T>
+class LargeArray {
+    static_assert(std::is_trivial<T>::value, "LargeArray holds trivial types");
+
+    T* m_Data = nullptr;
+    size_t m_Count = 0;
+    size_t m_MappedBytes = 0;
+    PageMode m_Mode = PageMode::Heap;
+
+public:
+    explicit LargeArray(size_t count, PageMode request = PageMode::Auto) : m_Count(count) {
+        size_t bytes = count * sizeof(T);
+        if (request == PageMode::Auto) {
+            request = bytes >= Huge::s_LargeArrayThreshold ? PageMode::Huge : PageMode::Heap;
+        }
+#if !defined(_WIN32)
+        if (request != PageMode::Heap && bytes != 0) {
+            size_t mapped = (bytes + Huge::s_HugePageSize - 1) & ~(Huge::s_HugePageSize - 1);
+            if (void* p = Huge::MapAligned(mapped)) {
+                m_Data = static_cast<T*>(p);
+                m_MappedBytes = mapped;
+                m_Mode = PageMode::Small;
+#if defined(MADV_HUGEPAGE)
+                if (request == PageMode::Huge && Huge::ThpSetting() != "never" &&
+                    ::madvise(p, mapped, MADV_HUGEPAGE) == 0) {
+                    m_Mode = PageMode::Huge;
+                }
+                if (request == PageMode::Small) {
+                    ::madvise(p, mapped, MADV_NOHUGEPAGE);      // THP "always" would promote it anyway
+                }
+#endif
+                return;
+            }
+        }
+#endif
+        m_Data = new T[count]();
+    }
+    ~LargeArray() {
+#if !defined(_WIN32)
+        if (m_MappedBytes != 0) {
+            ::munmap(m_Data, m_MappedBytes);
+            return;
+        }
+#endif
+        delete[] m_Data;
+    }
+    LargeArray(const LargeArray&) = delete;
+    LargeArray& operator =(const LargeArray&) = delete;
+
+    size_t Size() const { return m_Count; }
+    T* Data() { return m_Data; }
+    T& operator [](size_t i) { return m_Data[i]; }
+    const T& operator [](size_t i) const { return m_Data[i]; }
+
+    PageMode Mode() const { return m_Mode; }
+    size_t HugeBytes() const { return m_MappedBytes != 0 ? Huge::HugeBytesAt(m_Data) : 0; }
+};
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    // dTLB read misses of this thread, user space only; Valid() is false without perf access
+    class TlbCounter {
+        int m_Fd = -1;
+    public:
+        TlbCounter() {
+#if defined(__linux__)
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            m_Fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+        }
+        ~TlbCounter() {
+#if defined(__linux__)
+            if (m_Fd >= 0) {
+                ::close(m_Fd);
+            }
+#endif
+        }
+        bool Valid() const { return m_Fd >= 0; }
+        void Start() {
+#if defined(__linux__)
+            if (m_Fd >= 0) {
+                ::ioctl(m_Fd, PERF_EVENT_IOC_RESET, 0);
+                ::ioctl(m_Fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+        unsigned long long Stop() {
+            unsigned long long count = 0;
+#if defined(__linux__)
+            if (m_Fd >= 0) {
+                ::ioctl(m_Fd, PERF_EVENT_IOC_DISABLE, 0);
+                if (::read(m_Fd, &count, sizeof(count)) != sizeof(count)) {
+                    count = 0;
+                }
+            }
+#endif
+            return count;
+        }
+    };
+
+    void Bench(size_t megabytes) {
+        size_t count = (megabytes << 20) / sizeof(uint32_t);
+        const size_t reads = 20000000;
+        std::printf("THP: %s, %zu MB of uint32_t, %zu random reads\n",
+                    Huge::ThpSetting().empty() ? "not available" : Huge::ThpSetting().c_str(), megabytes, reads);
+
+        PageMode modes[] = {PageMode::Small, PageMode::Huge};
+        uint64_t firstSum = 0;
+        for (PageMode request : modes) {
+            LargeArray<uint32_t> array(count, request);
+            for (size_t i = 0; i < count; ++i) {
+                array[i] = static_cast<uint32_t>(i);
+            }
+            // 10 independent streams of xorshift indices, so the loads overlap like real lookups do
+            uint64_t state[10];
+            for (int s = 0; s < 10; ++s) {
+                state[s] = 0x9E3779B97F4A7C15ull * (s + 1);
+            }
+            TlbCounter tlb;
+            uint64_t sum = 0;
+            tlb.Start();
+            Clock::time_point t = Clock::now();
+            for (size_t i = 0; i < reads / 10; ++i) {
+                for (int s = 0; s < 10; ++s) {
+                    state[s] ^= state[s] << 13;
+                    state[s] ^= state[s] >> 7;
+                    state[s] ^= state[s] << 17;
+                    sum += array[state[s] % count];
+                }
+            }
+            double seconds = std::chrono::duration<double>(Clock::now() - t).count();
+            unsigned long long misses = tlb.Stop();
+
+            std::printf("  %-18s huge %5zu MB | %6.2f ns/read", PageModeName(array.Mode()), array.HugeBytes() >> 20,
+                        seconds * 1e9 / static_cast<double>(reads));
+            if (tlb.Valid()) {
+                std::printf(" | dTLB misses %.3f/read", static_cast<double>(misses) / static_cast<double>(reads));
+            } else {
+                std::printf(" | dTLB misses n/a (perf_event_open refused)");
+            }
+            if (request == modes[0]) {
+                firstSum = sum;
+            }
+            std::printf("%s\n", sum == firstSum ? "" : " MISMATCH");
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 1024);
+        return 0;
+    }
+
+    LargeArray<int> small(5);                       // int[5] stays a plain new[]
+    LargeArray<int> large(16 << 20);                // 64 MB
+    for (size_t i = 0; i < large.Size(); ++i) {
+        large[i] = static_cast<int>(i);
+    }
+    std::cout << "THP setting: " << (Huge::ThpSetting().empty() ? "not available" : Huge::ThpSetting()) << std::endl
+              << "int[5]: " << PageModeName(small.Mode()) << std::endl
+              << "64 MB: " << PageModeName(large.Mode()) << ", " << (large.HugeBytes() >> 20) << " MB on huge pages" << std::endl;
+    return 0;
+}
@@ -0,0 +1,420 @@
+/**
+ *          Blocked Array
+ * --------------------------------------------------
+ * Matrices built from the pointer types of 1_7_2_morePointer.cpp and 1_8_array.cpp:
+ *      int** pp            row of pointers, every row its own new int[cols] somewhere on the heap
+ *      int (*p5)[2]        pointer to a fixed-size row, only works when the width is a constant
+ *      typedef int MyArray[5];
+ * Walking pp[i][j] costs a dependent load per row, and column-wise walks (transpose, B in A*B)
+ *      touch a new cache line (and often a new page) on every step.
+ *
+ * View<T, Rank>        pointer + extents + strides, no ownership; any rank, sub-blocks of 2D views
+ * Array<T, Rank>       one contiguous row-major block that hands out Views
+ * TiledArray2D<T, N>   N x N tiles stored one after another (N = 32 ints -> 4 KB per tile)
+ *                      a tile is contiguous, so a tile op is a fixed-size loop over one page
+ *
+ * Transpose(src, dst)  cache-oblivious: split the longer side in half until the block fits
+ *                      in L1, without knowing the cache size
+ * Multiply(a, b, c)    c += a * b, blocked i/k/j loops for views (strided ones too), tile by tile for
+ *                      TiledArray2D; the innermost loop runs along a contiguous row (vectorized)
+ *
+ * Usage:
+ *      1_8_5_blockedArray --check          // every kernel against a naive loop, odd sizes
+ *      1_8_5_blockedArray --bench [N]      // N x N transpose and multiply vs int**
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+template <class T, size_t Rank>
+class View {
+    static_assert(Rank >= 1, "View needs at least one dimension");
+
+    T* m_Data = nullptr;
+    std::array<size_t, Rank> m_Extents{};
+    std::array<size_t, Rank> m_Strides{};
+
+public:
+    View() = default;
+    // row-major: the last index is contiguous
+    View(T* data, const std::array<size_t, Rank>& extents) : m_Data(data), m_Extents(extents) {
+        size_t stride = 1;
+        for (size_t d = Rank; d-- > 0;) {
+            m_Strides[d] = stride;
+            stride *= extents[d];
+        }
+    }
+    View(T* data, const std::array<size_t, Rank>& extents, const std::array<size_t, Rank>& strides)
+        : m_Data(data), m_Extents(extents), m_Strides(strides) {}
+
+    // View<int, 2> -> View<const int, 2>
+    template <class U, class = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+    View(const View<U, Rank>& other) : View(other.Data(), other.Extents(), other.Strides()) {}
+
+    T* Data() const { return m_Data; }
+    const std::array<size_t, Rank>& Extents() const { return m_Extents; }
+    const std::array<size_t, Rank>& Strides() const { return m_Strides; }
+    size_t Extent(size_t d) const { return m_Extents[d]; }
+    size_t Stride(size_t d) const { return m_Strides[d]; }
+
+    template <class... I>
+    T& operator ()(I... index) const {
+        static_assert(sizeof...(I) == Rank, "one index per dimension");
+        size_t indices[] = {static_cast<size_t>(index)...};
+        size_t offset = 0;
+        for (size_t d = 0; d < Rank; ++d) {
+            offset += indices[d] * m_Strides[d];
+        }
+        return m_Data[offset];
+    }
+
+    // rows x cols block starting at (row, col), same strides
+    View Block(size_t row, size_t col, size_t rows, size_t cols) const {
+        static_assert(Rank == 2, "Block is for 2D views");
+        return View(m_Data + row * m_Strides[0] + col * m_Strides[1], {rows, cols}, m_Strides);
+    }
+};
+
+template <class T, size_t Rank>
+class Array {
+    std::array<size_t, Rank> m_Extents;
+    std::vector<T> m_Data;
+
+    static size_t Count(const std::array<size_t, Rank>& extents) {
+        size_t count = 1;
+        for (size_t extent : extents) {
+            count *= extent;
+        }
+        return count;
+    }
+
+public:
+    explicit Array(const std::array<size_t, Rank>& extents) : m_Extents(extents), m_Data(Count(extents)) {}
+
+    size_t Extent(size_t d) const { return m_Extents[d]; }
+    size_t Size() const { return m_Data.size(); }
+    T* Data() { return m_Data.data(); }
+    const T* Data() const { return m_Data.data(); }
+
+    View<T, Rank> GetView() { return View<T, Rank>(m_Data.data(), m_Extents); }
+    View<const T, Rank> GetView() const { return View<const T, Rank>(m_Data.data(), m_Extents); }
+
+    template <class... I>
+    T& operator ()(I... index) { return GetView()(index...); }
+    template <class... I>
+    const T& operator ()(I... index) const { return GetView()(index...); }
+};
+
+// rows and cols are padded up to whole tiles (the padding stays 0)
+template <class T, size_t N = 32>
+class TiledArray2D {
+    size_t m_Rows, m_Cols;
+    size_t m_TileCols;
+    std::vector<T> m_Data;
+
+public:
+    static constexpr size_t s_Tile = N;
+
+    TiledArray2D(size_t rows, size_t cols)
+        : m_Rows(rows), m_Cols(cols), m_TileCols((cols + N - 1) / N), m_Data(((rows + N - 1) / N) * m_TileCols * N * N) {}
+
+    size_t Rows() const { return m_Rows; }
+    size_t Cols() const { return m_Cols; }
+    size_t TileRows() const { return (m_Rows + N - 1) / N; }
+    size_t TileCols() const { return m_TileCols; }
+
+    T* Tile(size_t tileRow, size_t tileCol) { return &m_Data[(tileRow * m_TileCols + tileCol) * N * N]; }
+    const T* Tile(size_t tileRow, size_t tileCol) const { return &m_Data[(tileRow * m_TileCols + tileCol) * N * N]; }
+
+    T& operator ()(size_t row, size_t col) { return Tile(row / N, col / N)[(row % N) * N + col % N]; }
+    const T& operator ()(size_t row, size_t col) const { return Tile(row / N, col / N)[(row % N) * N + col % N]; }
+
+    void From(View<const T, 2> src) {
+        for (size_t i = 0; i < m_Rows; ++i) {
+            for (size_t j = 0; j < m_Cols; ++j) {
+                (*this)(i, j) = src(i, j);
+            }
+        }
+    }
+    void To(View<T, 2> dst) const {
+        for (size_t i = 0; i < m_Rows; ++i) {
+            for (size_t j = 0; j < m_Cols; ++j) {
+                dst(i, j) = (*this)(i, j);
+            }
+        }
+    }
+};
+
+namespace Blocked {
+    constexpr size_t s_TransposeLeaf = 32;      // 32 x 32 ints: 4 KB a block, both in L1
+    constexpr size_t s_BlockI = 64, s_BlockK = 128, s_BlockJ = 256;
+
+    // dst(j, i) = src(i, j); dst is src.Extent(1) x src.Extent(0)
+    template <class T>
+    void Transpose(View<const T, 2> src, View<T, 2> dst) {
+        size_t rows = src.Extent(0), cols = src.Extent(1);
+        if (rows <= s_TransposeLeaf && cols <= s_TransposeLeaf) {
+            const T* s = src.Data();
+            T* d = dst.Data();
+            size_t srcRow = src.Stride(0), srcCol = src.Stride(1), dstRow = dst.Stride(0), dstCol = dst.Stride(1);
+            if (srcCol == 1 && dstCol == 1) {
+                for (size_t j = 0; j < cols; ++j) {     // row-major: fill dst row by row, no per-element strides
+                    T* dRow = d + j * dstRow;
+                    for (size_t i = 0; i < rows; ++i) {
+                        dRow[i] = s[i * srcRow + j];
+                    }
+                }
+            } else {
+                for (size_t i = 0; i < rows; ++i) {
+                    for (size_t j = 0; j < cols; ++j) {
+                        d[j * dstRow + i * dstCol] = s[i * srcRow + j * srcCol];
+                    }
+                }
+            }
+        } else if (rows >= cols) {
+            size_t half = rows / 2;
+            Transpose(src.Block(0, 0, half, cols), dst.Block(0, 0, cols, half));
+            Transpose(src.Block(half, 0, rows - half, cols), dst.Block(0, half, cols, rows - half));
+        } else {
+            size_t half = cols / 2;
+            Transpose(src.Block(0, 0, rows, half), dst.Block(0, 0, half, rows));
+            Transpose(src.Block(0, half, rows, cols - half), dst.Block(half, 0, cols - half, rows));
+        }
+    }
+
+    // c += a * b; the rows of b and c are walked by pointer when they are contiguous (Stride(1) == 1),
+    //      any other layout (a transposed view, a column) goes through View::operator ()
+    template <class T>
+    void Multiply(View<const T, 2> a, View<const T, 2> b, View<T, 2> c) {
+        size_t n = a.Extent(0), m = a.Extent(1), p = b.Extent(1);
+        bool rows = b.Stride(1) == 1 && c.Stride(1) == 1;
+        for (size_t i0 = 0; i0 < n; i0 += s_BlockI) {
+            size_t i1 = std::min(n, i0 + s_BlockI);
+            for (size_t k0 = 0; k0 < m; k0 += s_BlockK) {
+                size_t k1 = std::min(m, k0 + s_BlockK);
+                for (size_t j0 = 0; j0 < p; j0 += s_BlockJ) {
+                    size_t j1 = std::min(p, j0 + s_BlockJ);
+                    for (size_t i = i0; i < i1; ++i) {
+                        for (size_t k = k0; k < k1; ++k) {
+                            T value = a(i, k);
+                            if (rows) {
+                                T* cRow = &c(i, 0);
+                                const T* bRow = &b(k, 0);
+                                for (size_t j = j0; j < j1; ++j) {
+                                    cRow[j] += value * bRow[j];
+                                }
+                            } else {
+                                for (size_t j = j0; j < j1; ++j) {
+                                    c(i, j) += value * b(k, j);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // c += a * b over whole tiles: every inner loop has the constant trip count N
+    template <class T, size_t N>
+    void Multiply(const TiledArray2D<T, N>& a, const TiledArray2D<T, N>& b, TiledArray2D<T, N>& c) {
+        for (size_t ti = 0; ti < c.TileRows(); ++ti) {
+            for (size_t tk = 0; tk < a.TileCols(); ++tk) {
+                const T* aTile = a.Tile(ti, tk);
+                for (size_t tj = 0; tj < c.TileCols(); ++tj) {
+                    const T* bTile = b.Tile(tk, tj);
+                    T* cTile = c.Tile(ti, tj);
+                    for (size_t i = 0; i < N; ++i) {
+                        for (size_t k = 0; k < N; ++k) {
+                            T value = aTile[i * N + k];
+                            for (size_t j = 0; j < N; ++j) {
+                                cTile[i * N + j] += value * bTile[k * N + j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    // the int** layout: every row its own allocation
+    struct RowPointers {
+        int** rows;
+        size_t n, m;
+        RowPointers(size_t n_, size_t m_) : rows(new int*[n_]), n(n_), m(m_) {
+            for (size_t i = 0; i < n; ++i) {
+                rows[i] = new int[m]();
+            }
+        }
+        ~RowPointers() {
+            for (size_t i = 0; i < n; ++i) {
+                delete[] rows[i];
+            }
+            delete[] rows;
+        }
+    };
+
+    bool Check() {
+        std::mt19937 random(11);
+        bool ok = true;
+        size_t sizes[][3] = {{1, 1, 1}, {5, 3, 7}, {17, 33, 9}, {70, 45, 130}, {129, 257, 66}};
+        for (auto& size : sizes) {
+            size_t n = size[0], m = size[1], p = size[2];
+            Array<int, 2> a({n, m}), b({m, p}), c({n, p}), expected({n, p}), at({m, n});
+            for (size_t i = 0; i < a.Size(); ++i) {
+                a.Data()[i] = static_cast<int>(random() % 19) - 9;
+            }
+            for (size_t i = 0; i < b.Size(); ++i) {
+                b.Data()[i] = static_cast<int>(random() % 19) - 9;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = 0; j < p; ++j) {
+                    for (size_t k = 0; k < m; ++k) {
+                        expected(i, j) += a(i, k) * b(k, j);
+                    }
+                }
+            }
+
+            Blocked::Transpose<int>(a.GetView(), at.GetView());
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = 0; j < m; ++j) {
+                    ok = ok && at(j, i) == a(i, j);
+                }
+            }
+
+            Blocked::Multiply<int>(a.GetView(), b.GetView(), c.GetView());
+            ok = ok && std::equal(c.Data(), c.Data() + c.Size(), expected.Data());
+
+            // b and c stored column-major: same product through strided views
+            Array<int, 2> bColumns({p, m}), cColumns({p, n});
+            Blocked::Transpose<int>(b.GetView(), bColumns.GetView());
+            Array<int, 2> bRows({p, m});        // and back again from the strided view: the non-contiguous leaf
+            Blocked::Transpose<int>(View<const int, 2>(bColumns.Data(), {m, p}, {1, m}), bRows.GetView());
+            ok = ok && std::equal(bRows.Data(), bRows.Data() + bRows.Size(), bColumns.Data());
+            Blocked::Multiply<int>(a.GetView(), View<const int, 2>(bColumns.Data(), {m, p}, {1, m}),
+                                   View<int, 2>(cColumns.Data(), {n, p}, {1, n}));
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = 0; j < p; ++j) {
+                    ok = ok && cColumns(j, i) == expected(i, j);
+                }
+            }
+
+            TiledArray2D<int> ta(n, m), tb(m, p), tc(n, p);
+            ta.From(a.GetView());
+            tb.From(b.GetView());
+            Blocked::Multiply(ta, tb, tc);
+            Array<int, 2> back({n, p});
+            tc.To(back.GetView());
+            ok = ok && std::equal(back.Data(), back.Data() + back.Size(), expected.Data());
+        }
+
+        Array<int, 3> cube({2, 3, 4});      // ND: last index contiguous
+        cube(1, 2, 3) = 7;
+        ok = ok && cube.Data()[1 * 12 + 2 * 4 + 3] == 7;
+
+        std::cout << "transpose, multiply (row-major and strided), tiled multiply, 3D indexing | " << (ok ? "ok" : "MISMATCH") << std::endl;
+        return ok;
+    }
+
+    template <class F>
+    double Seconds(F f) {
+        Clock::time_point t = Clock::now();
+        f();
+        return std::chrono::duration<double>(Clock::now() - t).count();
+    }
+
+    void Bench(size_t n) {
+        std::mt19937 random(5);
+        RowPointers pa(n, n), pt(n, n);
+        Array<int, 2> a({n, n}), at({n, n});
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                a(i, j) = pa.rows[i][j] = static_cast<int>(random() % 7);
+            }
+        }
+
+        double naive = Seconds([&]() {
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    pt.rows[j][i] = pa.rows[i][j];
+                }
+            }
+        });
+        double oblivious = Seconds([&]() { Blocked::Transpose<int>(a.GetView(), at.GetView()); });
+        bool same = true;
+        for (size_t i = 0; i < n; ++i) {
+            same = same && std::equal(pt.rows[i], pt.rows[i] + n, &at(i, 0));
+        }
+        double cells = static_cast<double>(n) * static_cast<double>(n);
+        std::printf("%zu x %zu transpose | int** %.2f ns/cell, cache-oblivious %.2f ns/cell %s\n",
+                    n, n, naive * 1e9 / cells, oblivious * 1e9 / cells, same ? "" : "MISMATCH");
+
+        // multiply on a smaller square so the naive version finishes
+        size_t m = std::min<size_t>(n, 1024);
+        RowPointers pb(m, m), pc(m, m);
+        Array<int, 2> b({m, m}), c({m, m});
+        View<const int, 2> aBlock = View<const int, 2>(a.GetView()).Block(0, 0, m, m);
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = 0; j < m; ++j) {
+                b(i, j) = pb.rows[i][j] = static_cast<int>(random() % 7);
+            }
+        }
+        TiledArray2D<int> ta(m, m), tb(m, m), tc(m, m);
+        ta.From(aBlock);
+        tb.From(b.GetView());
+
+        double ijk = Seconds([&]() {
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t j = 0; j < m; ++j) {
+                    int sum = 0;
+                    for (size_t k = 0; k < m; ++k) {
+                        sum += pa.rows[i][k] * pb.rows[k][j];
+                    }
+                    pc.rows[i][j] = sum;
+                }
+            }
+        });
+        double blocked = Seconds([&]() { Blocked::Multiply<int>(aBlock, b.GetView(), c.GetView()); });
+        double tiled = Seconds([&]() { Blocked::Multiply(ta, tb, tc); });
+        Array<int, 2> tiledOut({m, m});
+        tc.To(tiledOut.GetView());
+        same = true;
+        for (size_t i = 0; i < m; ++i) {
+            same = same && std::equal(pc.rows[i], pc.rows[i] + m, &c(i, 0)) && std::equal(pc.rows[i], pc.rows[i] + m, &tiledOut(i, 0));
+        }
+        double ops = 2.0 * static_cast<double>(m) * static_cast<double>(m) * static_cast<double>(m);
+        std::printf("%zu x %zu multiply  | int** %.2f GOP/s, blocked row-major %.2f GOP/s, tiled %.2f GOP/s %s\n",
+                    m, m, ops / ijk / 1e9, ops / blocked / 1e9, ops / tiled / 1e9, same ? "" : "MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+        return Check() ? 0 : 1;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 4096);
+        return 0;
+    }
+
+    int arr[3][2] = {{1, 2}, {3, 4}, {5, 6}};
+    int (*p5)[2] = arr;                             // the fixed-width row pointer
+    View<int, 2> view(&p5[0][0], {3, 2});           // same memory, width known at runtime
+    Array<int, 2> t({2, 3});
+    Blocked::Transpose<int>(view, t.GetView());
+    std::cout << "view(2, 1) = " << view(2, 1) << ", transposed t(1, 2) = " << t(1, 2) << std::endl;
+    return 0;
+}
@@ -0,0 +1,498 @@
+/**
+ *          Packed Array
+ * --------------------------------------------------
+ * 1_9_structClassUnionBitField.cpp:
+ *      class Flag {
+ *          unsigned char m_Val1 : 2;
+ *          unsigned char m_Val2 : 3;
+ *      };
+ *      flag.m_Val1 = 5;        // only 01 is kept -> 1
+ *      unsigned char* ptr = &flag.m_Val1;     // (x) no pointer/reference to a bit field
+ * One Flag is 5 bits of data in 8 bits of storage, an array of a billion of them wastes 375 MB.
+ *
+ * PackedArray<2, 3> stores the 5 bit records back to back in 64 bit words:
+ *      field 0 in the low bits of a record (the same order GCC/Clang/MSVC give Flag on x86)
+ *      a[i].Field<0>() = 5     proxy reference, stores 5 & 0b11 = 1 like the bit field does
+ *      a.Get<1>(i), a.Set<1>(i, v)
+ *      Load / Store            whole records <-> uint32_t lanes
+ *      LoadField / StoreField  one field <-> uint8_t or uint32_t lanes
+ *
+ * Bulk ops work 8 records at a time: 8 records of W bits are exactly W bytes, so every group
+ *      starts on a byte. A group is split (or joined) with 3 levels of SSE2 shifts and masks
+ *      4W | 4W -> 2W | 2W | 2W | 2W -> 8 records of W bits, for records up to 16 bits;
+ *      wider records and the ragged ends use the scalar path (64 bit load at byte i*W/8, shift, mask).
+ *
+ * Little endian only (the words are also read as bytes).
+ *
+ * Usage:
+ *      1_9_2_packedArray                   // the Flag example
+ *      1_9_2_packedArray --check [N]       // against an array of real bit-field structs
+ *      1_9_2_packedArray --bench [M]       // M million Flags: memory and bulk unpack speed
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PACKED_SSE2 1
+#endif
+
+template <unsigned... Bits>
+class PackedArray {
+public:
+    static constexpr unsigned s_Fields = sizeof...(Bits);
+    static constexpr unsigned s_RecordBits = (Bits + ...);
+
+private:
+    static_assert(s_Fields >= 1, "at least one field");
+    static_assert(s_RecordBits >= 1 && s_RecordBits <= 32, "a record is 1 ~ 32 bits");
+
+    static constexpr unsigned s_Bits[s_Fields] = {Bits...};
+    static constexpr unsigned s_W = s_RecordBits;
+    static constexpr bool s_Simd = s_W <= 16;
+    static constexpr size_t s_Group = 8;            // records per bulk step, s_W bytes
+
+    static constexpr uint32_t Mask(unsigned bits) { return bits >= 32 ? 0xFFFFFFFFu : (uint32_t(1) << bits) - 1; }
+    static constexpr unsigned Shift(unsigned field) {
+        unsigned shift = 0;
+        for (unsigned f = 0; f < field; ++f) {
+            shift += s_Bits[f];
+        }
+        return shift;
+    }
+
+    size_t m_Size = 0;
+    std::vector<uint64_t> m_Words;      // 2 spare words: 16 byte loads at the last group stay inside
+
+    uint8_t* Bytes() { return reinterpret_cast<uint8_t*>(m_Words.data()); }
+    const uint8_t* Bytes() const { return reinterpret_cast<const uint8_t*>(m_Words.data()); }
+
+    uint32_t LoadRecord(size_t i) const {
+        size_t bit = i * s_W;
+        uint64_t window;
+        std::memcpy(&window, Bytes() + bit / 8, sizeof(window));
+        return static_cast<uint32_t>(window >> (bit % 8)) & Mask(s_W);
+    }
+    void StoreRecord(size_t i, uint32_t record) {
+        size_t bit = i * s_W;
+        uint64_t window;
+        std::memcpy(&window, Bytes() + bit / 8, sizeof(window));
+        uint64_t mask = static_cast<uint64_t>(Mask(s_W)) << (bit % 8);
+        window = (window & ~mask) | (static_cast<uint64_t>(record & Mask(s_W)) << (bit % 8));
+        std::memcpy(Bytes() + bit / 8, &window, sizeof(window));
+    }
+
+#if defined(PACKED_SSE2)
+    // the W bytes of group g -> records [r0 r1 r2 r3], [r4 r5 r6 r7]
+    void UnpackGroup(size_t group, __m128i& low, __m128i& high) const {
+        uint64_t lo, hi;
+        const uint8_t* p = Bytes() + group * s_W;
+        std::memcpy(&lo, p, 8);
+        std::memcpy(&hi, p + 8, 8);
+        // 8W bits -> two 4W bit halves
+        uint64_t e0, e1;
+        if constexpr (4 * s_W == 64) {
+            e0 = lo;
+            e1 = hi;
+        } else {
+            e0 = lo & ((uint64_t(1) << (4 * s_W)) - 1);
+            e1 = (lo >> (4 * s_W) | (4 * s_W > 32 ? hi << (64 - 4 * s_W) : 0)) & ((uint64_t(1) << (4 * s_W)) - 1);
+        }
+        __m128i x = _mm_set_epi64x(static_cast<long long>(e1), static_cast<long long>(e0));
+        // 4W -> 2W | 2W: [c0 c1 c2 c3] in 32 bit lanes
+        __m128i mask2 = _mm_set1_epi64x(static_cast<long long>((uint64_t(1) << (2 * s_W)) - 1));
+        __m128i c = _mm_or_si128(_mm_and_si128(x, mask2), _mm_slli_epi64(_mm_srli_epi64(x, 2 * s_W), 32));
+        // 2W -> W | W
+        __m128i mask1 = _mm_set1_epi64x(static_cast<long long>(Mask(s_W)));
+        __m128i a = _mm_unpacklo_epi32(c, _mm_setzero_si128());
+        __m128i b = _mm_unpackhi_epi32(c, _mm_setzero_si128());
+        low = _mm_or_si128(_mm_and_si128(a, mask1), _mm_slli_epi64(_mm_srli_epi64(a, s_W), 32));
+        high = _mm_or_si128(_mm_and_si128(b, mask1), _mm_slli_epi64(_mm_srli_epi64(b, s_W), 32));
+    }
+
+    // records (already masked to W bits) -> exactly the W bytes of group g
+    void PackGroup(size_t group, __m128i low, __m128i high) {
+        // W | W -> 2W in 64 bit lanes, then pick the low 32 bits of every lane
+        __m128i lowMask = _mm_set1_epi64x(0xFFFFFFFF);
+        __m128i a = _mm_or_si128(_mm_and_si128(low, lowMask), _mm_slli_epi64(_mm_srli_epi64(low, 32), s_W));
+        __m128i b = _mm_or_si128(_mm_and_si128(high, lowMask), _mm_slli_epi64(_mm_srli_epi64(high, 32), s_W));
+        __m128i c = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0)));
+        // 2W | 2W -> 4W
+        __m128i x = _mm_or_si128(_mm_and_si128(c, lowMask), _mm_slli_epi64(_mm_srli_epi64(c, 32), 2 * s_W));
+        uint64_t e[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(e), x);
+        // 4W | 4W -> 8W bits
+        uint64_t out[2];
+        if constexpr (4 * s_W == 64) {
+            out[0] = e[0];
+            out[1] = e[1];
+        } else {
+            out[0] = e[0] | e[1] << (4 * s_W);
+            out[1] = 4 * s_W > 32 ? e[1] >> (64 - 4 * s_W) : 0;
+        }
+        std::memcpy(Bytes() + group * s_W, out, s_W);
+    }
+#endif
+
+public:
+    template <unsigned Field>
+    class FieldRef {
+        PackedArray* m_Array;
+        size_t m_Index;
+    public:
+        FieldRef(PackedArray* array, size_t index) : m_Array(array), m_Index(index) {}
+        operator uint32_t() const { return m_Array->template Get<Field>(m_Index); }
+        // upper bits are dropped like a bit-field assignment: 5 into 2 bits stores 1
+        FieldRef& operator =(uint32_t value) {
+            m_Array->template Set<Field>(m_Index, value);
+            return *this;
+        }
+        FieldRef& operator =(const FieldRef& other) { return *this = static_cast<uint32_t>(other); }
+    };
+
+    class RecordRef {
+        PackedArray* m_Array;
+        size_t m_Index;
+    public:
+        RecordRef(PackedArray* array, size_t index) : m_Array(array), m_Index(index) {}
+        template <unsigned F>
+        FieldRef<F> Field() const { return FieldRef<F>(m_Array, m_Index); }
+        operator uint32_t() const { return m_Array->LoadRecord(m_Index); }
+        RecordRef& operator =(uint32_t record) {
+            m_Array->StoreRecord(m_Index, record);
+            return *this;
+        }
+        RecordRef& operator =(const RecordRef& other) { return *this = static_cast<uint32_t>(other); }
+    };
+
+    PackedArray() = default;
+    explicit PackedArray(size_t count) { Resize(count); }
+
+    size_t Size() const { return m_Size; }
+    size_t MemoryBytes() const { return m_Words.size() * sizeof(uint64_t); }
+
+    // new records are 0
+    void Resize(size_t count) {
+        for (size_t i = count; i < m_Size; ++i) {
+            StoreRecord(i, 0);
+        }
+        m_Size = count;
+        m_Words.resize((count * s_W + 63) / 64 + 2, 0);
+    }
+
+    RecordRef operator [](size_t i) { return RecordRef(this, i); }
+    uint32_t operator [](size_t i) const { return LoadRecord(i); }
+
+    template <unsigned Field>
+    uint32_t Get(size_t i) const {
+        static_assert(Field < s_Fields, "no such field");
+        return LoadRecord(i) >> Shift(Field) & Mask(s_Bits[Field]);
+    }
+
+    template <unsigned Field>
+    void Set(size_t i, uint32_t value) {
+        static_assert(Field < s_Fields, "no such field");
+        uint32_t mask = Mask(s_Bits[Field]) << Shift(Field);
+        StoreRecord(i, (LoadRecord(i) & ~mask) | ((value << Shift(Field)) & mask));
+    }
+
+    // out[k] = record first + k
+    void Load(size_t first, uint32_t* out, size_t count) const {
+        size_t i = 0;
+#if defined(PACKED_SSE2)
+        if constexpr (s_Simd) {
+            for (; i < count && (first + i) % s_Group != 0; ++i) {
+                out[i] = LoadRecord(first + i);
+            }
+            for (; i + s_Group <= count; i += s_Group) {
+                __m128i low, high;
+                UnpackGroup((first + i) / s_Group, low, high);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), low);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), high);
+            }
+        }
+#endif
+        for (; i < count; ++i) {
+            out[i] = LoadRecord(first + i);
+        }
+    }
+
+    // record first + k = in[k], bits above the record width are dropped
+    void Store(size_t first, const uint32_t* in, size_t count) {
+        size_t i = 0;
+#if defined(PACKED_SSE2)
+        if constexpr (s_Simd) {
+            for (; i < count && (first + i) % s_Group != 0; ++i) {
+                StoreRecord(first + i, in[i]);
+            }
+            __m128i mask = _mm_set1_epi32(static_cast<int>(Mask(s_W)));
+            for (; i + s_Group <= count; i += s_Group) {
+                __m128i low = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), mask);
+                __m128i high = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 4)), mask);
+                PackGroup((first + i) / s_Group, low, high);
+            }
+        }
+#endif
+        for (; i < count; ++i) {
+            StoreRecord(first + i, in[i]);
+        }
+    }
+
+    // out[k] = Get<Field>(first + k); uint8_t lanes need a field of 8 bits or less
+    template <unsigned Field, class Lane>
+    void LoadField(size_t first, Lane* out, size_t count) const {
+        static_assert(Field < s_Fields, "no such field");
+        static_assert(std::is_same<Lane, uint8_t>::value || std::is_same<Lane, uint32_t>::value, "uint8_t or uint32_t lanes");
+        static_assert(sizeof(Lane) * 8 >= s_Bits[Field], "the field does not fit the lane");
+        size_t i = 0;
+#if defined(PACKED_SSE2)
+        if constexpr (s_Simd) {
+            for (; i < count && (first + i) % s_Group != 0; ++i) {
+                out[i] = static_cast<Lane>(Get<Field>(first + i));
+            }
+            __m128i mask = _mm_set1_epi32(static_cast<int>(Mask(s_Bits[Field])));
+            for (; i + s_Group <= count; i += s_Group) {
+                __m128i low, high;
+                UnpackGroup((first + i) / s_Group, low, high);
+                low = _mm_and_si128(_mm_srli_epi32(low, Shift(Field)), mask);
+                high = _mm_and_si128(_mm_srli_epi32(high, Shift(Field)), mask);
+                if constexpr (sizeof(Lane) == 1) {
+                    __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(low, high), _mm_setzero_si128());
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), bytes);
+                } else {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), low);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), high);
+                }
+            }
+        }
+#endif
+        for (; i < count; ++i) {
+            out[i] = static_cast<Lane>(Get<Field>(first + i));
+        }
+    }
+
+    // Set<Field>(first + k, in[k]) for every k, the other fields keep their values
+    template <unsigned Field, class Lane>
+    void StoreField(size_t first, const Lane* in, size_t count) {
+        static_assert(Field < s_Fields, "no such field");
+        static_assert(std::is_same<Lane, uint8_t>::value || std::is_same<Lane, uint32_t>::value, "uint8_t or uint32_t lanes");
+        size_t i = 0;
+#if defined(PACKED_SSE2)
+        if constexpr (s_Simd) {
+            for (; i < count && (first + i) % s_Group != 0; ++i) {
+                Set<Field>(first + i, in[i]);
+            }
+            __m128i mask = _mm_set1_epi32(static_cast<int>(Mask(s_Bits[Field])));
+            __m128i keep = _mm_set1_epi32(static_cast<int>(~(Mask(s_Bits[Field]) << Shift(Field))));
+            for (; i + s_Group <= count; i += s_Group) {
+                __m128i newLow, newHigh;
+                if constexpr (sizeof(Lane) == 1) {
+                    uint64_t bytes;
+                    std::memcpy(&bytes, in + i, 8);
+                    __m128i words = _mm_unpacklo_epi8(_mm_cvtsi64_si128(static_cast<long long>(bytes)), _mm_setzero_si128());
+                    newLow = _mm_unpacklo_epi16(words, _mm_setzero_si128());
+                    newHigh = _mm_unpackhi_epi16(words, _mm_setzero_si128());
+                } else {
+                    newLow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                    newHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 4));
+                }
+                __m128i low, high;
+                UnpackGroup((first + i) / s_Group, low, high);
+                low = _mm_or_si128(_mm_and_si128(low, keep), _mm_slli_epi32(_mm_and_si128(newLow, mask), Shift(Field)));
+                high = _mm_or_si128(_mm_and_si128(high, keep), _mm_slli_epi32(_mm_and_si128(newHigh, mask), Shift(Field)));
+                PackGroup((first + i) / s_Group, low, high);
+            }
+        }
+#endif
+        for (; i < count; ++i) {
+            Set<Field>(first + i, in[i]);
+        }
+    }
+};
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    class Flag {
+    public:
+        unsigned char m_Val1 : 2;
+        unsigned char m_Val2 : 3;
+    };
+
+    // a wider record to cover a field that crosses byte boundaries (and the scalar path, 20 bits)
+    struct Wide {
+        uint32_t a : 4;
+        uint32_t b : 9;
+        uint32_t c : 3;
+    };
+    struct Wider {
+        uint32_t a : 7;
+        uint32_t b : 13;
+    };
+
+    bool CheckFlag(size_t count) {
+        std::mt19937 random(2);
+        std::vector<Flag> reference(count);
+        PackedArray<2, 3> packed(count);
+        bool ok = true;
+        for (size_t i = 0; i < count; ++i) {
+            unsigned v1 = random() % 16, v2 = random() % 32;        // often too big for the field
+            reference[i].m_Val1 = static_cast<unsigned char>(v1 & 0xFF);
+            reference[i].m_Val2 = static_cast<unsigned char>(v2 & 0xFF);
+            if (i % 2 == 0) {
+                packed[i].Field<0>() = v1;
+                packed[i].Field<1>() = v2;
+            } else {
+                packed.Set<0>(i, v1);
+                packed.Set<1>(i, v2);
+            }
+        }
+        std::vector<uint8_t> val1(count), val2(count);
+        for (size_t first = 0; first < 20 && ok; ++first) {
+            packed.LoadField<0>(first, val1.data(), count - first);
+            packed.LoadField<1>(first, val2.data(), count - first);
+            for (size_t i = first; i < count; ++i) {
+                ok = ok && val1[i - first] == reference[i].m_Val1 && val2[i - first] == reference[i].m_Val2;
+                ok = ok && packed.Get<0>(i) == reference[i].m_Val1 && packed[i].Field<1>() == reference[i].m_Val2;
+            }
+        }
+
+        // bulk store of one field: the other one must not move
+        for (size_t i = 0; i < count; ++i) {
+            val2[i] = static_cast<uint8_t>(random());
+            reference[i].m_Val2 = static_cast<unsigned char>(val2[i]);
+        }
+        packed.StoreField<1>(3, val2.data() + 3, count - 6);
+        for (size_t i = 3; i < count - 3; ++i) {
+            ok = ok && packed.Get<0>(i) == reference[i].m_Val1 && packed.Get<1>(i) == reference[i].m_Val2;
+        }
+        return ok;
+    }
+
+    template <class Packed, class Record, class SetFields>
+    bool CheckRecords(size_t count, SetFields setFields) {
+        std::mt19937 random(4);
+        std::vector<Record> reference(count);
+        Packed packed(count);
+        std::vector<uint32_t> raw(count), loaded(count);
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t r = static_cast<uint32_t>(random());
+            setFields(reference[i], r);
+            raw[i] = r;
+        }
+        packed.Store(5, raw.data() + 5, count - 5);
+        for (size_t i = 0; i < 5; ++i) {
+            packed[i] = raw[i];
+        }
+        packed.Load(0, loaded.data(), count);
+        bool ok = true;
+        for (size_t i = 0; i < count; ++i) {
+            Record back;
+            setFields(back, loaded[i]);
+            ok = ok && std::memcmp(&back, &reference[i], sizeof(Record)) == 0;
+        }
+        std::vector<uint32_t> field(count);
+        packed.template LoadField<1>(1, field.data(), count - 1);
+        for (size_t i = 1; i < count; ++i) {
+            ok = ok && field[i - 1] == reference[i].b;
+        }
+        return ok;
+    }
+
+    bool Check(size_t count) {
+        bool flag = CheckFlag(count);
+        bool wide = CheckRecords<PackedArray<4, 9, 3>, Wide>(count, [](Wide& w, uint32_t r) {
+            std::memset(&w, 0, sizeof(w));
+            w.a = r & 0xF;
+            w.b = r >> 4 & 0x1FF;
+            w.c = r >> 13 & 0x7;
+        });
+        bool wider = CheckRecords<PackedArray<7, 13>, Wider>(count, [](Wider& w, uint32_t r) {
+            std::memset(&w, 0, sizeof(w));
+            w.a = r & 0x7F;
+            w.b = r >> 7 & 0x1FFF;
+        });
+        std::cout << count << " records | Flag (5 bit) " << (flag ? "ok" : "MISMATCH") << ", 16 bit " << (wide ? "ok" : "MISMATCH")
+                  << ", 20 bit " << (wider ? "ok" : "MISMATCH") << std::endl;
+        return flag && wide && wider;
+    }
+
+    template <class F>
+    double Seconds(F f) {
+        Clock::time_point t = Clock::now();
+        f();
+        return std::chrono::duration<double>(Clock::now() - t).count();
+    }
+
+    void Bench(size_t millions) {
+        size_t count = millions * 1000000;
+        std::mt19937 random(6);
+        std::vector<Flag> flags(count);
+        PackedArray<2, 3> packed(count);
+        std::vector<uint8_t> values(count);
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = static_cast<uint8_t>(random() % 8);
+            flags[i].m_Val1 = values[i] & 3;
+            flags[i].m_Val2 = values[i] & 7;
+        }
+        double store = Seconds([&]() { packed.StoreField<1>(0, values.data(), count); });
+        packed.StoreField<0>(0, values.data(), count);
+
+        std::vector<uint8_t> out(count);
+        uint64_t sum[3] = {0, 0, 0};
+        double seconds[3];
+        seconds[0] = Seconds([&]() {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = flags[i].m_Val2;
+            }
+        });
+        for (uint8_t v : out) {
+            sum[0] += v;
+        }
+        seconds[1] = Seconds([&]() {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = static_cast<uint8_t>(packed.Get<1>(i));
+            }
+        });
+        for (uint8_t v : out) {
+            sum[1] += v;
+        }
+        seconds[2] = Seconds([&]() { packed.LoadField<1>(0, out.data(), count); });
+        for (uint8_t v : out) {
+            sum[2] += v;
+        }
+
+        double n = static_cast<double>(count);
+        std::printf("%zuM Flags | memory: Flag[] %zu MB, packed %zu MB\n", millions, count >> 20, packed.MemoryBytes() >> 20);
+        std::printf("m_Val2 -> uint8_t[]: Flag[] %.2f ns, packed Get %.2f ns, packed LoadField %.2f ns | StoreField %.2f ns %s\n",
+                    seconds[0] * 1e9 / n, seconds[1] * 1e9 / n, seconds[2] * 1e9 / n, store * 1e9 / n,
+                    sum[0] == sum[1] && sum[1] == sum[2] ? "" : "MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+        return Check(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 100000) ? 0 : 1;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 200);
+        return 0;
+    }
+
+    PackedArray<2, 3> flags(1000);
+    flags[7].Field<0>() = 3;
+    flags[7].Field<1>() = 7;
+    flags[8].Field<0>() = 5;        // 101 -> 01
+    flags[8].Field<1>() = 15;       // 1111 -> 111
+    std::cout << flags[7].Field<0>() << " " << flags[7].Field<1>() << " | " << flags[8].Field<0>() << " " << flags[8].Field<1>()
+              << " | 1000 Flags in " << flags.MemoryBytes() << " bytes" << std::endl;
+    return 0;
+}
@@ -0,0 +1,322 @@
+/**
+ *          Variant Array
+ * --------------------------------------------------
+ * 1_9_structClassUnionBitField.cpp:
+ *      union U {
+ *          C c;        // 8 bytes
+ *          S1 s1;      // 8 bytes
+ *          S2 s2;      // 12 bytes
+ *      };
+ *      EXPECT_TRUE(sizeof(u) == sizeof(S2));
+ * Every element pays for S2, and a union does not even know which member is alive.
+ *      std::variant<C, S1, S2> knows, and costs 16 bytes (12 + tag + padding) per element.
+ * Our arrays are mostly S1, so most of that is padding.
+ *
+ * VariantArray<Ts...>:
+ *      tags        one byte per element, in their own array
+ *      payloads    one dense std::vector per type, an S1 costs 8 bytes no matter how big S2 is
+ *      element i   -> pool slot by rank: every 64 elements store how many of each type came
+ *                     before, then count the same tag inside the block (SSE2 compare + popcount)
+ *      Visit(f)    calls f for every element of one type, then the next type:
+ *                  no switch per element, every loop is over one array of one type
+ *      VisitInOrder(f) the original order, walks the tags with one cursor per pool
+ *
+ * Usage:
+ *      1_9_3_variantArray --check [N]      // against std::vector<std::variant<...>>
+ *      1_9_3_variantArray --bench [N]      // memory and visitation vs std::variant
+ */
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+template <class... Ts>
+class VariantArray {
+    static_assert(sizeof...(Ts) >= 1 && sizeof...(Ts) < 255, "1 ~ 254 types");
+
+    static constexpr size_t s_Types = sizeof...(Ts);
+    static constexpr size_t s_Block = 64;
+    static constexpr uint8_t s_NoTag = 0xFF;        // padding after the last element
+
+    template <class T, size_t I = 0>
+    static constexpr uint8_t TagOf() {
+        static_assert(I < s_Types, "not one of the VariantArray types");
+        if constexpr (std::is_same<T, typename std::tuple_element<I, std::tuple<Ts...>>::type>::value) {
+            return static_cast<uint8_t>(I);
+        } else {
+            return TagOf<T, I + 1>();
+        }
+    }
+
+    std::vector<uint8_t> m_Tags;                            // padded to whole blocks
+    std::vector<std::array<uint32_t, s_Types>> m_Before;    // per block: elements of each type before it
+    std::array<uint32_t, s_Types> m_Counts{};
+    std::tuple<std::vector<Ts>...> m_Pools;
+    size_t m_Size = 0;
+
+    // elements with this tag in [block start, i)
+    size_t CountInBlock(size_t i, uint8_t tag) const {
+        size_t begin = i / s_Block * s_Block;
+        size_t n = i - begin;
+        const uint8_t* tags = m_Tags.data() + begin;
+#if defined(__SSE2__) || defined(_M_X64)
+        uint64_t equal = 0;
+        __m128i t = _mm_set1_epi8(static_cast<char>(tag));
+        for (size_t part = 0; part < s_Block / 16; ++part) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + part * 16));
+            equal |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, t)))) << (part * 16);
+        }
+        uint64_t below = n == 0 ? 0 : equal & (~uint64_t(0) >> (64 - n));
+#if defined(_MSC_VER)
+        return static_cast<size_t>(__popcnt64(below));
+#else
+        return static_cast<size_t>(__builtin_popcountll(below));
+#endif
+#else
+        size_t count = 0;
+        for (size_t k = 0; k < n; ++k) {
+            count += tags[k] == tag;
+        }
+        return count;
+#endif
+    }
+
+    template <class F, size_t... I>
+    void VisitPools(F& f, std::index_sequence<I...>) {
+        (..., [&]() {
+            for (auto& value : std::get<I>(m_Pools)) {
+                f(value);
+            }
+        }());
+    }
+
+    template <class F, size_t I = 0>
+    void Dispatch(F& f, uint8_t tag, std::array<uint32_t, s_Types>& cursor) {
+        if constexpr (I < s_Types) {
+            if (tag == I) {
+                f(std::get<I>(m_Pools)[cursor[I]++]);
+            } else {
+                Dispatch<F, I + 1>(f, tag, cursor);
+            }
+        }
+    }
+
+public:
+    size_t Size() const { return m_Size; }
+    uint8_t Tag(size_t i) const { return m_Tags[i]; }
+
+    template <class T>
+    static constexpr uint8_t TagFor() { return TagOf<T>(); }
+
+    template <class T>
+    size_t Count() const { return m_Counts[TagOf<T>()]; }
+
+    template <class T>
+    void Push(const T& value) {
+        constexpr uint8_t tag = TagOf<T>();
+        if (m_Size % s_Block == 0) {
+            m_Before.push_back(m_Counts);
+            m_Tags.resize(m_Tags.size() + s_Block, s_NoTag);
+        }
+        m_Tags[m_Size++] = tag;
+        std::get<tag>(m_Pools).push_back(value);
+        ++m_Counts[tag];
+    }
+
+    // nullptr if element i holds another type
+    template <class T>
+    const T* Get(size_t i) const {
+        constexpr uint8_t tag = TagOf<T>();
+        if (m_Tags[i] != tag) {
+            return nullptr;
+        }
+        return &std::get<tag>(m_Pools)[m_Before[i / s_Block][tag] + CountInBlock(i, tag)];
+    }
+    template <class T>
+    T* Get(size_t i) { return const_cast<T*>(static_cast<const VariantArray&>(*this).Get<T>(i)); }
+
+    // every element of Ts[0], then every element of Ts[1], ...; f takes each type (generic lambda)
+    template <class F>
+    void Visit(F f) {
+        VisitPools(f, std::index_sequence_for<Ts...>());
+    }
+
+    template <class F>
+    void VisitInOrder(F f) {
+        std::array<uint32_t, s_Types> cursor{};
+        for (size_t i = 0; i < m_Size; ++i) {
+            Dispatch(f, m_Tags[i], cursor);
+        }
+    }
+
+    // what the vectors hold allocated, growth slack included
+    size_t MemoryBytes() const {
+        size_t bytes = m_Tags.capacity() + m_Before.capacity() * sizeof(m_Before[0]);
+        std::apply([&](const auto&... pool) { ((bytes += pool.capacity() * sizeof(pool[0])), ...); }, m_Pools);
+        return bytes;
+    }
+};
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    // the members of union U
+    class C {
+        int m_Val1 = 0;
+        int m_Val2 = 0;
+    public:
+        int GetVal1() const { return m_Val1; }
+        void SetVal1(int val) { m_Val1 = val; }
+    };
+    struct S1 {
+        int x;
+        int y;
+    };
+    struct S2 {
+        int x;
+        int y;
+        int z;
+    };
+    union U {
+        C c;
+        S1 s1;
+        S2 s2;
+    };
+
+    typedef std::variant<C, S1, S2> Variant;
+
+    struct Sum {
+        long long& total;
+        void operator ()(const C& c) const { total += c.GetVal1(); }
+        void operator ()(const S1& s) const { total += s.x + s.y; }
+        void operator ()(const S2& s) const { total += s.x + s.y + s.z; }
+    };
+
+    // 80% S1, 10% C, 10% S2
+    template <class Add>
+    void Fill(size_t count, Add add) {
+        std::mt19937 random(8);
+        for (size_t i = 0; i < count; ++i) {
+            int r = static_cast<int>(random() % 10);
+            int v = static_cast<int>(random() % 1000);
+            if (r < 8) {
+                add(Variant(S1{v, 1}));
+            } else if (r < 9) {
+                C c;
+                c.SetVal1(v);
+                add(Variant(c));
+            } else {
+                add(Variant(S2{v, 2, 3}));
+            }
+        }
+    }
+
+    void PushVariant(VariantArray<C, S1, S2>& array, const Variant& v) {
+        std::visit([&](const auto& value) { array.Push(value); }, v);
+    }
+
+    bool Check(size_t count) {
+        std::vector<Variant> reference;
+        VariantArray<C, S1, S2> array;
+        Fill(count, [&](const Variant& v) {
+            reference.push_back(v);
+            PushVariant(array, v);
+        });
+        const VariantArray<C, S1, S2>& readOnly = array;
+        bool ok = array.Size() == reference.size();
+        for (size_t i = 0; i < reference.size() && ok; ++i) {
+            ok = ok && array.Tag(i) == reference[i].index();
+            if (const S1* s = std::get_if<S1>(&reference[i])) {
+                const S1* p = array.Get<S1>(i);
+                ok = ok && p != nullptr && p->x == s->x && p->y == s->y && array.Get<S2>(i) == nullptr;
+            } else if (const S2* s = std::get_if<S2>(&reference[i])) {
+                const S2* p = array.Get<S2>(i);
+                ok = ok && p != nullptr && p->x == s->x && p->z == s->z && array.Get<C>(i) == nullptr;
+            } else {
+                const C* p = readOnly.Get<C>(i);
+                ok = ok && p != nullptr && p->GetVal1() == std::get<C>(reference[i]).GetVal1() && readOnly.Get<S1>(i) == nullptr;
+            }
+        }
+        std::vector<size_t> order;
+        array.VisitInOrder([&](const auto& value) { order.push_back(VariantArray<C, S1, S2>::TagFor<std::decay_t<decltype(value)>>()); });
+        for (size_t i = 0; i < reference.size() && ok; ++i) {
+            ok = ok && order[i] == reference[i].index();
+        }
+        long long expected = 0, grouped = 0, inOrder = 0;
+        for (const Variant& v : reference) {
+            std::visit(Sum{expected}, v);
+        }
+        array.Visit(Sum{grouped});
+        array.VisitInOrder(Sum{inOrder});
+        ok = ok && grouped == expected && inOrder == expected;
+        std::cout << count << " elements | " << (ok ? "ok" : "MISMATCH") << std::endl;
+        return ok;
+    }
+
+    template <class F>
+    double Seconds(F f) {
+        Clock::time_point t = Clock::now();
+        f();
+        return std::chrono::duration<double>(Clock::now() - t).count();
+    }
+
+    void Bench(size_t count) {
+        std::vector<Variant> variants;
+        variants.reserve(count);
+        VariantArray<C, S1, S2> array;
+        Fill(count, [&](const Variant& v) {
+            variants.push_back(v);
+            PushVariant(array, v);
+        });
+
+        long long sum[3] = {0, 0, 0};
+        double seconds[3];
+        seconds[0] = Seconds([&]() {
+            for (const Variant& v : variants) {
+                std::visit(Sum{sum[0]}, v);
+            }
+        });
+        seconds[1] = Seconds([&]() { array.Visit(Sum{sum[1]}); });
+        seconds[2] = Seconds([&]() { array.VisitInOrder(Sum{sum[2]}); });
+
+        double n = static_cast<double>(count);
+        std::printf("%zu elements (80%% S1, 10%% C, 10%% S2)\n", count);
+        std::printf("  memory: U[] %zu MB (%zu B each), std::variant %zu MB (%zu B each), VariantArray %zu MB (%.2f B each)\n",
+                    count * sizeof(U) >> 20, sizeof(U), count * sizeof(Variant) >> 20, sizeof(Variant),
+                    array.MemoryBytes() >> 20, static_cast<double>(array.MemoryBytes()) / n);
+        std::printf("  visit:  std::visit %.2f ns, tag-batched %.2f ns, in order %.2f ns %s\n",
+                    seconds[0] * 1e9 / n, seconds[1] * 1e9 / n, seconds[2] * 1e9 / n,
+                    sum[0] == sum[1] && sum[1] == sum[2] ? "" : "MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0) {
+        return Check(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 100000) ? 0 : 1;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        Bench(argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 20000000);
+        return 0;
+    }
+
+    VariantArray<C, S1, S2> array;
+    array.Push(S1{10, 20});
+    array.Push(S2{1, 2, 3});
+    array.Push(S1{30, 40});
+    std::cout << "element 2: S1 {" << array.Get<S1>(2)->x << ", " << array.Get<S1>(2)->y << "}, "
+              << "element 1 as S1: " << (array.Get<S1>(1) == nullptr ? "nullptr" : "?") << std::endl;
+    return 0;
+}